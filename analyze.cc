@@ -0,0 +1,176 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "gcg.h"
+#include "thread_pool.h"
+
+// One analyzed turn in binary output, after a header of MAGIC. Moves are
+// not included; the CSV has them.
+struct AnalysisRecord {
+    static constexpr char MAGIC[8] = { 'S', 'C', 'R', 'B', 'A', 'N', 'L', '1' };
+
+    uint32_t file;  // index of the file in the order given
+    uint16_t turn;
+    uint8_t player;
+    uint8_t kind;   // GcgTurn::Kind
+    int16_t played_score;
+    int16_t best_score;
+    float played_equity;
+    float best_equity;
+    uint32_t rank;  // 0 if the rack was not logged
+    uint32_t moves;
+};
+
+static_assert(sizeof(AnalysisRecord) == 28, "binary output depends on the AnalysisRecord layout");
+
+// Position and word as GCG writes them, blanks lowercase.
+std::string formatMove(const Move& move) {
+    std::string row = std::to_string(move.y + 1);
+    std::string column(1, 'A' + move.x);
+    std::string word = move.word();
+    for (int i = 0; i < move.length; i++) {
+        if (move.isBlank(i)) word[i] = tolower(word[i]);
+    }
+    return (move.dir == Direction::ACROSS ? row + column : column + row) + " " + word;
+}
+
+std::string formatPlayed(const TurnAnalysis& analysis) {
+    switch (analysis.played.kind) {
+        case GcgTurn::Kind::PLAY: return formatMove(analysis.move);
+        case GcgTurn::Kind::EXCHANGE: return "-" + analysis.played.exchanged;
+        case GcgTurn::Kind::WITHDRAWN: return "--";
+        default: return "-";
+    }
+}
+
+void writeCsv(std::ostream& out, const std::string& filename, const TurnAnalysis& analysis) {
+    out << filename << "," << analysis.turn << "," << analysis.played.player << "," << analysis.played.rack << ","
+        << formatPlayed(analysis) << "," << analysis.played.score << ",";
+    if (analysis.analyzed) {
+        out << analysis.played_equity << "," << analysis.rank << "," << analysis.moves << ",";
+        if (analysis.has_best) {
+            out << formatMove(analysis.best) << "," << analysis.best.score << "," << analysis.best.equity << ","
+                << analysis.equityLost();
+        } else {
+            out << ",,," << analysis.equityLost();
+        }
+    } else {
+        out << ",,,,,,";
+    }
+    out << "\n";
+}
+
+void writeBinary(std::ostream& out, uint32_t file, const TurnAnalysis& analysis) {
+    AnalysisRecord record;
+    memset(&record, 0, sizeof(record));
+    record.file = file;
+    record.turn = analysis.turn;
+    record.player = analysis.played.player;
+    record.kind = analysis.played.kind;
+    record.played_score = analysis.played.score;
+    record.played_equity = analysis.played_equity;
+    if (analysis.analyzed) {
+        record.rank = analysis.rank;
+        record.moves = analysis.moves;
+    }
+    if (analysis.has_best) {
+        record.best_score = analysis.best.score;
+        record.best_equity = analysis.best.equity;
+    }
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+// Replays one GCG file, writing a line or record per turn to out. Returns
+// the number of positions analyzed.
+long analyzeFile(const Lexicon& lexicon, MoveGenerator::Algorithm algorithm, const std::string& filename,
+                 uint32_t index, bool binary, std::ostream& out) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        std::cerr << filename << ": cannot open" << std::endl;
+        return 0;
+    }
+    GcgReader reader(in);
+    GameAnalyzer analyzer(lexicon, algorithm);
+    GcgTurn turn;
+    TurnAnalysis analysis;
+    long positions = 0;
+    while (reader.next(turn)) {
+        if (!analyzer.analyze(turn, analysis)) {
+            std::cerr << filename << ": turn " << analysis.turn << " does not fit the board, stopping" << std::endl;
+            break;
+        }
+        if (analysis.analyzed) positions++;
+        if (binary) writeBinary(out, index, analysis);
+        else writeCsv(out, filename, analysis);
+    }
+    if (reader.skippedCount() > 0) {
+        std::cerr << filename << ": " << reader.skippedCount() << " plays could not be parsed" << std::endl;
+    }
+    return positions;
+}
+
+// Replays GCG game logs and reports, for every turn, the best move in the
+// position and how the played move compares. Files are analyzed in
+// parallel, a batch at a time, and their output written in the order given.
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    bool binary = false;
+    MoveGenerator::Algorithm algorithm = MoveGenerator::Algorithm::TRIE;
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        std::string opt = argv[arg];
+        if (opt == "-t" && arg + 1 < argc) threads = std::stoul(argv[++arg]);
+        else if (opt == "-b") binary = true;
+        else if (opt == "-g") algorithm = MoveGenerator::Algorithm::GADDAG;
+        else if (opt == "-h" || opt == "--help") {
+            std::cerr << "usage: " << argv[0] << " [-t threads] [-b] [-g] [FILE.gcg ...]" << std::endl;
+            std::cerr << "  FILE  game logs to analyze; read from standard input, one per line, if none" << std::endl;
+            std::cerr << "  -b    write binary records instead of CSV" << std::endl;
+            std::cerr << "  -g    generate moves with the GADDAG" << std::endl;
+            return 1;
+        } else break;
+    }
+
+    std::vector<std::string> files(argv + arg, argv + argc);
+    if (files.empty()) {
+        std::string line;
+        while (getline(std::cin, line)) {
+            if (!line.empty()) files.push_back(line);
+        }
+    }
+
+    Lexicon lexicon(algorithm == MoveGenerator::Algorithm::GADDAG);
+    ThreadPool pool(threads);
+    std::ios::sync_with_stdio(false);
+    if (binary) std::cout.write(AnalysisRecord::MAGIC, sizeof(AnalysisRecord::MAGIC));
+    else std::cout << "file,turn,player,rack,played,score,equity,rank,moves,best,best_score,best_equity,equity_lost\n";
+
+    // enough files per batch to keep every thread busy, few enough that
+    // their output stays small
+    const size_t BATCH = 8 * pool.size();
+    long positions = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < files.size(); first += BATCH) {
+        size_t count = std::min(BATCH, files.size() - first);
+        std::vector<std::stringstream> outputs(count);
+        std::vector<long> counts(count, 0);
+        pool.parallelFor(count, [&](size_t i) {
+            counts[i] = analyzeFile(lexicon, algorithm, files[first + i], first + i, binary, outputs[i]);
+        });
+        for (size_t i = 0; i < count; i++) {
+            std::cout << outputs[i].str();
+            positions += counts[i];
+        }
+    }
+    std::cout << std::flush;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << files.size() << " files, " << positions << " positions in " << elapsed << " s: "
+              << positions / elapsed << " positions/s" << std::endl;
+    return 0;
+}
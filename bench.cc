@@ -0,0 +1,524 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+#include "game.h"
+#include "query.h"
+
+// A board position, one string per row as Board::loadRows takes it, and the
+// rack to move from it.
+struct Position {
+    std::vector<std::string> rows;
+    std::string rack;
+};
+
+// The empty board, then positions every few turns of two seeded IMPOSSIBLE
+// self-play games. Kept as text so the corpus stays the same whatever later
+// changes do to the games themselves.
+const Position CORPUS[] = {
+    { {
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+    }, "AEIRST "},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        ".REPORTS.......",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+    }, "EIIKNOT"},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "......A........",
+        "..TOKEN........",
+        ".REPORTS.......",
+        "..DEW.I........",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+    }, " CDEGIU"},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "......A........",
+        "..TOKEN........",
+        ".REPORTS.......",
+        "..DEW.I........",
+        "......ClUDGIES.",
+        ".........AI..I.",
+        ".............N.",
+        ".............DA",
+        ".............OU",
+        ".............NE",
+    }, "AGGILNR"},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        ".....H.........",
+        ".....A.........",
+        ".....YA........",
+        "..TOKEN........",
+        ".REPORTS.......",
+        "..DEW.I........",
+        "......ClUDGIES.",
+        ".........AI..I.",
+        "...ARGLING...N.",
+        ".QIS.........DA",
+        "AIT..........OU",
+        ".............NE",
+    }, "ABEEMOT"},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        ".....H...AJEE..",
+        ".....AMOEBAE...",
+        ".....YA........",
+        "..TOKEN........",
+        ".REPORTS...FIFI",
+        "..DEW.I....R...",
+        "......ClUDGIES.",
+        ".........AIT.I.",
+        "...ARGLING.T.N.",
+        ".QIS.........DA",
+        "AIT..........OU",
+        ".............NE",
+    }, "CLMNPUX"},
+    { {
+        ".......P.......",
+        ".......U.......",
+        ".......L.......",
+        "WHOOSH.M.AJEE..",
+        ".....AMOEBAE...",
+        ".....YA....LUXE",
+        "..TOKEN........",
+        ".REPORTS...FIFI",
+        "..DEW.I....R...",
+        "......ClUDGIES.",
+        ".........AIT.I.",
+        "...ARGLING.T.N.",
+        ".QIS.........DA",
+        "AIT..........OU",
+        ".......OVErTONE",
+    }, "BCELNNV"},
+    { {
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...COWMaN......",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+        "...............",
+    }, "GINQSVY"},
+    { {
+        "...............",
+        "...............",
+        "...R...........",
+        "...E...........",
+        "...T...........",
+        "...R...........",
+        "...A...........",
+        "...COWMaN......",
+        "...K...NYS.....",
+        ".......V.......",
+        ".......I.......",
+        ".......L.......",
+        ".......I.......",
+        ".......N.......",
+        ".......G.......",
+    }, "ADDOOUY"},
+    { {
+        "...............",
+        "...............",
+        ".AUREOLAE......",
+        "...E...........",
+        "...T...........",
+        "...R...........",
+        "...AD..........",
+        "...COWMaN......",
+        "...KO..NYS.....",
+        "....D..V.......",
+        "....Y..I.......",
+        ".......L.......",
+        "......QI.......",
+        ".....ZIN.......",
+        ".....O.G.......",
+    }, "ABEEEII"},
+    { {
+        ".......SAX.....",
+        ".F...BEE.......",
+        ".AUREOLAE......",
+        ".W.E...........",
+        ".N.T...........",
+        ".E.R...........",
+        ".R.AD..........",
+        "...COWMaN......",
+        "...KO..NYS.....",
+        "....D..V.......",
+        "....Y..I.......",
+        ".......L.......",
+        "......QI.......",
+        ".THIAZINE......",
+        ".....O.G.......",
+    }, "ACGHITU"},
+    { {
+        ".......SAX.....",
+        ".F...BEE.......",
+        ".AUREOLAE......",
+        ".W.E...........",
+        ".N.T...........",
+        "ME.R.J.........",
+        "OR.ADo.........",
+        "G..COWMaN......",
+        "...KO..NYS.....",
+        "....D..V.......",
+        "....Y..I.......",
+        ".......L.......",
+        "TACH..QI.......",
+        ".THIAZINE......",
+        "STEP.O.G.......",
+    }, "EIINRTU"},
+    { {
+        ".......SAX....P",
+        ".F...BEE.INTIRE",
+        ".AUREOLAE.....R",
+        ".W.E....DING..V",
+        ".N.T.....FOULIE",
+        "ME.R.J.........",
+        "OR.ADo.........",
+        "G..COWMaN......",
+        "...KO..NYS.....",
+        "....D..V.......",
+        "....Y..I.......",
+        ".......L.......",
+        "TACH..QI.......",
+        ".THIAZINE......",
+        "STEP.O.G.......",
+    }, "AAIORST"},
+};
+
+// Per-operation timings of one benchmark over its repetitions.
+struct Result {
+    std::string name;
+    int reps;
+    long ops;
+    double best_ns;
+    double mean_ns;
+};
+
+class Bench {
+private:
+    int reps;
+    std::vector<Result> results;
+
+public:
+    Bench(int reps) : reps(reps) {}
+
+    // Calls setup() then times body() reps times. body returns how many
+    // operations it did, so the results come out per operation.
+    void run(std::string name, std::function<void()> setup, std::function<long()> body) {
+        Result result = { name, reps, 0, 0, 0 };
+        double total = 0;
+        for (int rep = 0; rep < reps; rep++) {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            result.ops = body();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ns /= std::max(1L, result.ops);
+            result.best_ns = rep == 0 ? ns : std::min(result.best_ns, ns);
+            total += ns;
+        }
+        result.mean_ns = total / reps;
+        results.push_back(result);
+        std::cerr << name << ": " << result.best_ns << " ns/op" << std::endl;
+    }
+
+    void run(std::string name, std::function<long()> body) { run(name, [] {}, body); }
+
+    void printCsv() {
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "benchmark,reps,ops,best_ns_per_op,mean_ns_per_op" << std::endl;
+        for (const Result& result : results) {
+            std::cout << result.name << "," << result.reps << "," << result.ops << "," << result.best_ns << ","
+                      << result.mean_ns << std::endl;
+        }
+    }
+
+    void printJson() {
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "[" << std::endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& result = results[i];
+            std::cout << "  {\"benchmark\": \"" << result.name << "\", \"reps\": " << result.reps
+                      << ", \"ops\": " << result.ops << ", \"best_ns_per_op\": " << result.best_ns
+                      << ", \"mean_ns_per_op\": " << result.mean_ns << "}"
+                      << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        std::cout << "]" << std::endl;
+    }
+};
+
+typedef std::vector<std::unique_ptr<Board>> Boards;
+
+Boards loadCorpus(const Lexicon& lexicon) {
+    Boards boards;
+    for (const Position& position : CORPUS) {
+        boards.push_back(std::make_unique<Board>(lexicon.words()));
+        boards.back()->loadRows(position.rows);
+    }
+    return boards;
+}
+
+long generateAll(const Lexicon& lexicon, Boards& boards, MoveGenerator::Algorithm algorithm) {
+    for (size_t i = 0; i < boards.size(); i++) {
+        TopKSink best(1);
+        MoveGenerator(lexicon, *boards[i], Rack(CORPUS[i].rack), algorithm).generate(best);
+    }
+    return boards.size();
+}
+
+// The positions of a seeded game on a layout with its own bag, each with
+// the rack to move, both players making the highest-scoring play.
+template <typename Layout>
+struct LayoutGame {
+    std::vector<BasicBoard<Layout>> boards;
+    std::vector<Rack> racks;
+};
+
+template <typename Layout>
+LayoutGame<Layout> playGreedy(const Lexicon& lexicon, unsigned seed) {
+    LayoutGame<Layout> game;
+    BasicBoard<Layout> board(lexicon.words());
+    BasicTilebag<typename Layout::Tiles> bag(seed);
+    Rack racks[2];
+    bag.draw(racks[0], Rack::SIZE);
+    bag.draw(racks[1], Rack::SIZE);
+    for (int player = 0, passes = 0; passes < 2 && !racks[0].empty() && !racks[1].empty(); player = 1 - player) {
+        game.boards.push_back(board);
+        game.racks.push_back(racks[player]);
+        BasicTopKSink<Layout> best(1);
+        BasicMoveGenerator<Layout>(lexicon, board, racks[player], MoveGenerator::Algorithm::TRIE).generate(best);
+        typename BasicBoard<Layout>::Move move;
+        if (!best.choose(move)) {
+            passes++;
+            continue;
+        }
+        passes = 0;
+        board.playMove(move, racks[player]);
+        bag.draw(racks[player], Rack::SIZE - racks[player].size());
+    }
+    return game;
+}
+
+template <typename Layout>
+long generateAll(const Lexicon& lexicon, LayoutGame<Layout>& game, MoveGenerator::Algorithm algorithm) {
+    for (size_t i = 0; i < game.boards.size(); i++) {
+        BasicTopKSink<Layout> best(1);
+        BasicMoveGenerator<Layout>(lexicon, game.boards[i], game.racks[i], algorithm).generate(best);
+    }
+    return game.boards.size();
+}
+
+int main(int argc, char** argv) {
+    int reps = 5;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::max(1, std::stoi(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--reps N] [--json]" << std::endl;
+            return 1;
+        }
+    }
+    std::ifstream compiled_lexicon("dict.lex"), compiled_gaddag("dict.gdg");
+    if (!compiled_lexicon.good() || !compiled_gaddag.good()) {
+        std::cerr << "bench needs dict.lex and dict.gdg; run make first" << std::endl;
+        return 1;
+    }
+
+    Bench bench(reps);
+
+    bench.run("load/dict.txt", [] {
+        Trie words("dict.txt");
+        return 1L;
+    });
+    bench.run("load/dict.lex", [] {
+        Trie words("dict.lex");
+        return 1L;
+    });
+    bench.run("load/dict.gdg", [] {
+        Trie words("dict.gdg", Trie::Kind::GADDAG);
+        return 1L;
+    });
+
+    Lexicon lexicon(true);
+    const Trie& trie = lexicon.words();
+
+    // every tenth word, and the same word with its last letter changed
+    std::vector<std::string> words;
+    std::ifstream fin("dict.txt");
+    std::string line;
+    for (int i = 0; getline(fin, line); i++) {
+        if (i % 10 != 0 || line.empty()) continue;
+        words.push_back(line);
+        line.back() = line.back() == 'Z' ? 'A' : line.back() + 1;
+        words.push_back(line);
+    }
+    long legal = 0;
+    bench.run("trie/isLegal", [&] {
+        for (const std::string& word : words) legal += trie.isLegal(word);
+        return static_cast<long>(words.size());
+    });
+
+    Boards boards = loadCorpus(lexicon);
+    bench.run("board/recomputeValidCrosses", [&] {
+        for (std::unique_ptr<Board>& board : boards) board->recomputeValidCrosses();
+        return static_cast<long>(boards.size());
+    });
+
+    // the best move in each position, played with its incremental
+    // cross-check updates onto a fresh copy of the position
+    std::vector<Move> best(boards.size());
+    std::vector<bool> has_best(boards.size());
+    for (size_t i = 0; i < boards.size(); i++) {
+        TopKSink top(1);
+        MoveGenerator(lexicon, *boards[i], Rack(CORPUS[i].rack), MoveGenerator::Algorithm::TRIE).generate(top);
+        has_best[i] = top.choose(best[i]);
+    }
+    Boards fresh;
+    bench.run("board/playMove", [&] { fresh = loadCorpus(lexicon); }, [&] {
+        for (size_t i = 0; i < fresh.size(); i++) {
+            Rack rack(CORPUS[i].rack);
+            if (has_best[i]) fresh[i]->playMove(best[i], rack);
+        }
+        return static_cast<long>(fresh.size());
+    });
+
+    bench.run("movegen/trie", [&] { return generateAll(lexicon, boards, MoveGenerator::Algorithm::TRIE); });
+    bench.run("movegen/gaddag", [&] { return generateAll(lexicon, boards, MoveGenerator::Algorithm::GADDAG); });
+
+    // the same on the other layouts, each instantiated for its own size
+    LayoutGame<PracticeLayout> practice = playGreedy<PracticeLayout>(lexicon, 1);
+    LayoutGame<SuperLayout> super_game = playGreedy<SuperLayout>(lexicon, 1);
+    bench.run("movegen/practice", [&] { return generateAll(lexicon, practice, MoveGenerator::Algorithm::TRIE); });
+    bench.run("movegen/super", [&] { return generateAll(lexicon, super_game, MoveGenerator::Algorithm::TRIE); });
+
+    // every move generated in every position, checked and scored again
+    std::vector<std::vector<Move>> moves(boards.size());
+    for (size_t i = 0; i < boards.size(); i++) {
+        MoveBuffer buffer;
+        MoveGenerator(lexicon, *boards[i], Rack(CORPUS[i].rack), MoveGenerator::Algorithm::TRIE).generate(buffer);
+        moves[i] = buffer.moves;
+    }
+    bench.run("board/placeWord", [&] {
+        long ops = 0;
+        for (size_t i = 0; i < boards.size(); i++) {
+            Rack rack(CORPUS[i].rack);
+            for (const Move& move : moves[i]) {
+                boards[i]->placeWord(move.word(), move.x, move.y, move.dir, rack, true);
+                ops++;
+            }
+        }
+        return ops;
+    });
+
+    // every position of a seeded IMPOSSIBLE self-play game, saved and
+    // restored with and without its cross-checks
+    std::vector<Snapshot> snapshots;
+    Game(lexicon, Game::ComputerMode::IMPOSSIBLE, MoveGenerator::Algorithm::TRIE, 1, 1)
+        .selfPlay(Game::ComputerMode::IMPOSSIBLE, &snapshots);
+    std::vector<SnapshotCrosses> crosses(snapshots.size());
+    Game restored(lexicon, MoveGenerator::Algorithm::TRIE);
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        restored.load(snapshots[i]);
+        restored.save(snapshots[i], snapshots[i].to_move, &crosses[i]);
+    }
+    bench.run("snapshot/save", [&] {
+        Snapshot snapshot;
+        for (size_t i = 0; i < snapshots.size(); i++) restored.save(snapshot, 0, &crosses[i]);
+        return static_cast<long>(snapshots.size());
+    });
+    bench.run("snapshot/load", [&] {
+        for (const Snapshot& snapshot : snapshots) restored.load(snapshot);
+        return static_cast<long>(snapshots.size());
+    });
+    bench.run("snapshot/load+crosses", [&] {
+        for (size_t i = 0; i < snapshots.size(); i++) restored.load(snapshots[i], &crosses[i]);
+        return static_cast<long>(snapshots.size());
+    });
+
+    // anagrams of fifty seeded eight-tile racks with two blanks, the
+    // hardest case for hint lookups
+    WordFinder finder(trie);
+    std::vector<WordQuery> queries;
+    for (unsigned seed = 1; queries.size() < 50; seed++) {
+        Tilebag bag(seed);
+        Rack rack;
+        bag.draw(rack, 6);
+        if (rack.hasBlank()) continue;
+        WordQuery query;
+        query.rack = rack.toString() + "??";
+        queries.push_back(query);
+    }
+    long found = 0;
+    bench.run("query/anagram", [&] {
+        for (const WordQuery& query : queries) found += finder.find(query).size();
+        return static_cast<long>(queries.size());
+    });
+
+    if (json) bench.printJson();
+    else bench.printCsv();
+
+    return 0;
+}
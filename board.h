@@ -0,0 +1,828 @@
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cassert>
+#include <cstdint>
+
+#include "geometry.h"
+#include "stats.h"
+#include "trie.h"
+
+enum Direction { ACROSS = 0, DOWN };
+
+constexpr Direction crossOf(Direction dir) { return dir == Direction::ACROSS ? Direction::DOWN : Direction::ACROSS; }
+
+// The tiles on a player's rack, as a count per letter plus the blank. Copying
+// one is cheap and taking or returning a tile is O(1), so move generation
+// can take tiles off a rack and put them back as it recurses.
+class Rack {
+public:
+    static constexpr int SIZE = 7;
+    static constexpr char BLANK = ' ';
+
+private:
+    uint8_t counts[27];
+    uint32_t present;
+    uint8_t total;
+
+    static int index(char ch) {
+        assert(isTile(ch));
+        return ch == BLANK ? 26 : ch - 'A';
+    }
+
+public:
+    // whether ch is a tile a rack can hold: A-Z or BLANK
+    static bool isTile(char ch) { return ch == BLANK || (ch >= 'A' && ch <= 'Z'); }
+
+    Rack() : counts{}, present(0), total(0) {}
+
+    // The tiles in a string, letters in either case and BLANK for a blank.
+    // Anything else is not a tile and is left out.
+    Rack(std::string tiles) : Rack() {
+        for (char ch : tiles) {
+            ch = toupper(static_cast<unsigned char>(ch));
+            if (isTile(ch)) add(ch);
+        }
+    }
+
+    void add(char ch) {
+        STAT_COUNT(RACK_MUTATIONS);
+        int idx = index(ch);
+        counts[idx]++;
+        present |= 1u << idx;
+        total++;
+    }
+
+    void take(char ch) {
+        STAT_COUNT(RACK_MUTATIONS);
+        int idx = index(ch);
+        assert(counts[idx] > 0);
+        if (--counts[idx] == 0) present &= ~(1u << idx);
+        total--;
+    }
+
+    // Takes the tile that would be played as letter ch: ch itself if the
+    // rack has one, otherwise a blank. Returns the tile taken.
+    char takeFor(char ch) {
+        char tile = has(ch) ? ch : BLANK;
+        take(tile);
+        return tile;
+    }
+
+    bool has(char ch) const { return (present & (1u << index(ch))) != 0; }
+
+    bool canPlay(char ch) const { return has(ch) || hasBlank(); }
+
+    bool hasBlank() const { return has(BLANK); }
+
+    int count(char ch) const { return counts[index(ch)]; }
+
+    // letters A-Z on the rack, bit 0 being 'A'
+    uint32_t letterMask() const { return present & ((1u << 26) - 1); }
+
+    // letters A-Z as in letterMask, and bit 26 for the blank
+    uint32_t tileMask() const { return present; }
+
+    size_t size() const { return total; }
+
+    bool empty() const { return total == 0; }
+
+    // the tiles in order, blanks first
+    std::string toString() const {
+        std::string ret(counts[26], BLANK);
+        for (int i = 0; i < 26; i++) ret.append(counts[i], 'A' + i);
+        return ret;
+    }
+};
+
+class Tile {
+private:
+    char letter;
+    int points;
+
+public:
+    Tile(char letter, int points) : letter(letter), points(points)
+    {}
+
+    char getLetter() const { return letter; }
+
+    int getPoints() const { return points; }
+
+    std::string toString() {
+        std::stringstream ret;
+        ret << " \e[1;33m" << letter << points << "\e[0m";
+        if (points < 10) ret << " ";
+        return ret.str();
+    }
+};
+
+class Cell {
+public:
+    enum Type { NORMAL = 0, DW, TW, DL, TL };
+
+private:
+    Tile tile;
+    Type type;
+    uint32_t down_crosses;
+    uint32_t across_crosses;
+    int16_t down_points;
+    int16_t across_points;
+
+public:
+    Cell(Type type)
+        : tile('\0', 0), type(type), down_crosses(0xFFFFFFFF), across_crosses(0xFFFFFFFF),
+          down_points(-1), across_points(-1)
+    {};
+
+    Cell() : Cell(Type::NORMAL) {}
+
+    void fill(Tile tile) { this->tile = tile; }
+
+    void setType(Type type) { this->type = type; }
+
+    bool isEmpty() const { return tile.getLetter() == '\0'; }
+
+    Tile getTile() const { return tile; }
+
+    Type getType() const { return type; }
+
+    int letterMultiplier() const { return type == DL ? 2 : type == TL ? 3 : 1; }
+
+    int wordMultiplier() const { return type == DW ? 2 : type == TW ? 3 : 1; }
+
+    bool isValidCross(char ch, Direction dir) const {
+        int idx = ch - 'A';
+        if (dir == Direction::ACROSS) {
+            return (across_crosses & (1 << idx)) != 0;
+        } else if (dir == Direction::DOWN) {
+            return (down_crosses & (1 << idx)) != 0;
+        }
+        return false;
+    }
+
+    uint32_t getValidCrosses(Direction dir) const {
+        return dir == Direction::ACROSS ? across_crosses : down_crosses;
+    }
+
+    // Points of the tiles touching the cell in direction dir, i.e. the rest
+    // of the cross-word a tile placed here forms, or -1 if there are none.
+    int getCrossPoints(Direction dir) const {
+        return dir == Direction::ACROSS ? across_points : down_points;
+    }
+
+    void setValidCrosses(Direction dir, uint32_t crosses, int points) {
+        if (dir == Direction::ACROSS) {
+            across_crosses = crosses;
+            across_points = points;
+        } else if (dir == Direction::DOWN) {
+            down_crosses = crosses;
+            down_points = points;
+        }
+    }
+
+    bool sameValidCrosses(const Cell& other) const {
+        return across_crosses == other.across_crosses && down_crosses == other.down_crosses &&
+               across_points == other.across_points && down_points == other.down_points;
+    }
+
+    std::string toString() {
+        std::stringstream ret;
+        if (isEmpty()) {
+            switch (type) {
+                case DW: {
+                    ret << " \e[1;35mDW\e[0m ";
+                } break;
+                case TW: {
+                    ret << " \e[1;31mTW\e[0m ";
+                } break;
+                case DL: {
+                    ret << " \e[1;36mDL\e[0m ";
+                } break;
+                case TL: {
+                    ret << " \e[1;34mTL\e[0m ";
+                } break;
+                default: {
+                    ret << "    ";
+                } break;
+            }
+        }
+        else {
+            ret << tile.toString();
+        }
+        return ret.str();
+    }
+};
+
+// A scored play: the letters of the main word in order (tiles already on
+// the board included), where it goes, which letters are tiles from the rack
+// and which of those are blanks. A move fits one line of its layout.
+template <typename Layout>
+struct BasicMove {
+    static constexpr int MAX_LENGTH = Layout::SIZE;
+
+    char letters[MAX_LENGTH];
+    int8_t length;
+    int8_t x;
+    int8_t y;
+    Direction dir;
+    LineMask<Layout::SIZE> placed;
+    LineMask<Layout::SIZE> blanks;
+    int score;
+    // score plus the value of the tiles kept, when there is a leave table
+    float equity;
+
+    std::string word() const { return std::string(letters, length); }
+
+    bool isPlaced(int i) const { return (placed & (1u << i)) != 0; }
+
+    bool isBlank(int i) const { return (blanks & (1u << i)) != 0; }
+};
+
+// Running score of a word as its letters are laid down one cell at a time.
+// placeWord and the move generators both score through this.
+struct WordScore {
+    static constexpr int BINGO = 50;
+
+    int main_points = 0;
+    int word_mul = 1;
+    int cross_points = 0;
+    int tiles = 0;
+
+    // a new tile worth points, placed on cell, in a word running across
+    // cross_dir
+    void place(const Cell& cell, int points, Direction cross_dir) {
+        int letter_points = points * cell.letterMultiplier();
+        main_points += letter_points;
+        word_mul *= cell.wordMultiplier();
+        int cross = cell.getCrossPoints(cross_dir);
+        if (cross >= 0) cross_points += (cross + letter_points) * cell.wordMultiplier();
+        tiles++;
+    }
+
+    // a tile already on the board
+    void cover(const Cell& cell) { main_points += cell.getTile().getPoints(); }
+
+    int total() const {
+        return main_points * word_mul + cross_points + (tiles == Rack::SIZE ? BINGO : 0);
+    }
+};
+
+// The board of a layout, with its tiles, premium squares and cross-checks.
+// Board is the standard one; other layouts are their own instantiations.
+template <typename Layout>
+class BasicBoard {
+public:
+    static_assert(validLayout<Layout>(), "layout rows must be SIZE squares of known premiums");
+
+    static constexpr int SIZE = Layout::SIZE;
+
+    using Move = BasicMove<Layout>;
+    using Line = LineMask<SIZE>;
+
+    // how many moves made with makeMove can be undone at once
+    static constexpr int MAX_UNDO = 32;
+
+private:
+    // A cell as it was before a move changed it.
+    struct SavedCell {
+        int8_t x;
+        int8_t y;
+        Cell cell;
+    };
+
+    // A move fills at most Rack::SIZE cells, and updates the cross-checks
+    // of the two ends of its own line and of each line across it.
+    static constexpr int SAVED_PER_MOVE = Rack::SIZE + 2 * (Rack::SIZE + 1);
+
+    struct UndoFrame {
+        int16_t saved;  // saved_count before the move
+        bool empty;
+    };
+
+    // the word list cross-checks and placeWord check against
+    const Trie* words;
+
+    Cell board[SIZE][SIZE];
+
+    bool empty;
+
+    // Which squares hold tiles, a bitmask per line: bit x of row_tiles[y]
+    // and bit y of column_tiles[x] for the tile at (x, y).
+    Line row_tiles[SIZE] = {};
+    Line column_tiles[SIZE] = {};
+
+    SavedCell saved[MAX_UNDO * SAVED_PER_MOVE];
+    UndoFrame frames[MAX_UNDO];
+    int saved_count = 0;
+    int undo_depth = 0;
+
+    static constexpr Line FULL = static_cast<Line>((uint64_t(1) << SIZE) - 1);
+
+    const Line* lines(Direction dir) const { return dir == Direction::ACROSS ? row_tiles : column_tiles; }
+
+    // Squares of a line next to a tile on either side along it.
+    Line alongNeighbors(int line, Direction dir) const {
+        Line occupied = lines(dir)[line];
+        return ((occupied << 1) | (occupied >> 1)) & FULL;
+    }
+
+    void occupy(int x, int y) {
+        row_tiles[y] |= 1u << x;
+        column_tiles[x] |= 1u << y;
+    }
+
+    void vacate(int x, int y) {
+        row_tiles[y] &= ~(1u << x);
+        column_tiles[x] &= ~(1u << y);
+    }
+
+    // Empties every square, resetting its cross-checks, and forgets any
+    // moves pending undo.
+    void clearTiles() {
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) board[y][x] = Cell(board[y][x].getType());
+        }
+        std::fill(row_tiles, row_tiles + SIZE, 0);
+        std::fill(column_tiles, column_tiles + SIZE, 0);
+        saved_count = undo_depth = 0;
+        empty = true;
+    }
+
+    // Puts a tile on an empty square without touching any cross-checks.
+    void putTile(int x, int y, char letter, bool blank) {
+        board[y][x].fill(Tile(letter, blank ? 0 : tilePoints(letter)));
+        occupy(x, y);
+        empty = false;
+    }
+
+    void save(int x, int y) {
+        assert(saved_count < MAX_UNDO * SAVED_PER_MOVE);
+        saved[saved_count++] = { static_cast<int8_t>(x), static_cast<int8_t>(y), board[y][x] };
+    }
+
+    static int tilePoints(char letter) { return Layout::Tiles::POINTS[letter - 'A']; }
+
+    // The premium a square of Layout::PREMIUMS stands for.
+    static constexpr Cell::Type premium(char ch) {
+        switch (ch) {
+            case 'd': return Cell::Type::DL;
+            case 't': return Cell::Type::TL;
+            case 'D': return Cell::Type::DW;
+            case 'T': return Cell::Type::TW;
+            default: return Cell::Type::NORMAL;
+        }
+    }
+
+    // Squares are addressed by line and position along it, as the move
+    // generators do: (pos, line) for ACROSS and (line, pos) for DOWN. Code
+    // templated on the direction walks a line with a fixed stride instead
+    // of testing which way it runs at every step.
+    template <Direction DIR>
+    static int xOf(int line, int pos) { return DIR == Direction::ACROSS ? pos : line; }
+
+    template <Direction DIR>
+    static int yOf(int line, int pos) { return DIR == Direction::ACROSS ? line : pos; }
+
+    template <Direction DIR>
+    Cell& at(int line, int pos) { return board[yOf<DIR>(line, pos)][xOf<DIR>(line, pos)]; }
+
+    template <Direction DIR>
+    bool occupied(int line, int pos) const { return (lines(DIR)[line] >> pos) & 1; }
+
+    // Letters that can go at pos given the tiles touching it along the
+    // line: the run before it is walked once from the root, then each child
+    // letter of that node walks the run after it. Also adds up the points of
+    // those tiles.
+    template <Direction DIR>
+    uint32_t crossMask(int line, int pos, int& points) {
+        int start = pos;
+        while (start > 0 && occupied<DIR>(line, start - 1)) start--;
+        int end = pos + 1;
+        while (end < SIZE && occupied<DIR>(line, end)) end++;
+        points = 0;
+        for (int i = start; i < end; i++) {
+            if (i != pos) points += at<DIR>(line, i).getTile().getPoints();
+        }
+
+        const TrieNode* node = words->getRoot();
+        for (int i = start; node != nullptr && i < pos; i++) {
+            node = node->childAt(at<DIR>(line, i).getTile().getLetter());
+        }
+        if (node == nullptr) return 0;
+
+        uint32_t ret = 0;
+        uint32_t letters = node->childMask();
+        while (letters != 0) {
+            int idx = __builtin_ctz(letters);
+            letters &= letters - 1;
+            const TrieNode* curr = node->childAt('A' + idx);
+            for (int i = pos + 1; curr != nullptr && i < end; i++) {
+                curr = curr->childAt(at<DIR>(line, i).getTile().getLetter());
+            }
+            if (curr != nullptr && curr->isTerminal()) ret |= 1u << idx;
+        }
+        return ret;
+    }
+
+    template <Direction DIR>
+    bool hasNeighbor(int line, int pos) const { return (alongNeighbors(line, DIR) >> pos) & 1; }
+
+    // Cross-checks in a direction only change once the cell has a tile next
+    // to it in that direction; until then every letter is allowed.
+    void updateValidCrosses(int x, int y, Cell& cell) {
+        if (!cell.isEmpty()) return;
+        STAT_COUNT(CROSS_UPDATES);
+        int points;
+        if (hasNeighbor<Direction::ACROSS>(y, x)) {
+            uint32_t crosses = crossMask<Direction::ACROSS>(y, x, points);
+            cell.setValidCrosses(Direction::ACROSS, crosses, points);
+        }
+        if (hasNeighbor<Direction::DOWN>(x, y)) {
+            uint32_t crosses = crossMask<Direction::DOWN>(x, y, points);
+            cell.setValidCrosses(Direction::DOWN, crosses, points);
+        }
+    }
+
+    void updateValidCrosses(int x, int y) { updateValidCrosses(x, y, board[y][x]); }
+
+    // Updates the cross-checks of the empty cells bounding the run of tiles
+    // through pos. These are the only cells whose cross-checks can change
+    // when that run grows. With record set, saves them for unmakeMove first.
+    template <Direction DIR>
+    void updateRunEnds(int line, int pos, bool record) {
+        int start = pos;
+        while (start >= 0 && occupied<DIR>(line, start)) start--;
+        if (start >= 0) {
+            if (record) save(xOf<DIR>(line, start), yOf<DIR>(line, start));
+            updateValidCrosses(xOf<DIR>(line, start), yOf<DIR>(line, start));
+        }
+        int end = pos;
+        while (end < SIZE && occupied<DIR>(line, end)) end++;
+        if (end < SIZE) {
+            if (record) save(xOf<DIR>(line, end), yOf<DIR>(line, end));
+            updateValidCrosses(xOf<DIR>(line, end), yOf<DIR>(line, end));
+        }
+    }
+
+    template <Direction DIR>
+    int applyMove(const Move& move, Rack& rack, bool record) {
+        int line = DIR == Direction::ACROSS ? move.y : move.x;
+        int start = DIR == Direction::ACROSS ? move.x : move.y;
+        for (int i = 0; i < move.length; i++) {
+            if (!move.isPlaced(i)) continue;
+            char ch = move.letters[i];
+            int x = xOf<DIR>(line, start + i), y = yOf<DIR>(line, start + i);
+            rack.take(move.isBlank(i) ? Rack::BLANK : ch);
+            if (record) save(x, y);
+            board[y][x].fill(Tile(ch, move.isBlank(i) ? 0 : tilePoints(ch)));
+            occupy(x, y);
+        }
+        empty = false;
+        {
+            STAT_TIME(CROSS_UPDATE);
+            updateRunEnds<DIR>(line, start, record);
+            for (int i = 0; i < move.length; i++) {
+                if (move.isPlaced(i)) updateRunEnds<crossOf(DIR)>(start + i, line, record);
+            }
+        }
+#ifdef VERIFY_CROSSES
+        assert(validCrossesUpToDate());
+#endif
+        return move.score;
+    }
+
+    int applyMove(const Move& move, Rack& rack, bool record) {
+        if (move.dir == Direction::ACROSS) return applyMove<Direction::ACROSS>(move, rack, record);
+        return applyMove<Direction::DOWN>(move, rack, record);
+    }
+
+    // Checks the incrementally maintained cross-checks against a full
+    // recompute. Only used when built with -DVERIFY_CROSSES.
+    bool validCrossesUpToDate() {
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) {
+                Cell expected = board[y][x];
+                updateValidCrosses(x, y, expected);
+                if (!expected.sameValidCrosses(board[y][x])) return false;
+            }
+        }
+        return true;
+    }
+
+    template <Direction DIR>
+    bool isLegalHelper(const std::string& word, unsigned int i, int line, int pos, Rack& rack) {
+        if (i >= word.length()) return true;
+        char ch = toupper(static_cast<unsigned char>(word[i]));
+        const Cell& cell = at<DIR>(line, pos + i);
+        if (!cell.isEmpty()) {
+            if (cell.getTile().getLetter() != ch) return false;
+        } else if (!cell.isValidCross(ch, crossOf(DIR)) || !rack.canPlay(ch)) {
+            return false;
+        }
+        bool remove = cell.isEmpty();
+        if (remove) ch = rack.takeFor(ch);
+        bool ret = isLegalHelper<DIR>(word, i + 1, line, pos, rack);
+        if (remove) rack.add(ch);
+        return ret;
+    }
+
+    // The letters of the run of tiles ending just before pos, and of the
+    // one starting just after it.
+    template <Direction DIR>
+    std::string runBefore(int line, int pos) {
+        int start = pos;
+        while (start > 0 && occupied<DIR>(line, start - 1)) start--;
+        std::string ret;
+        for (int i = start; i < pos; i++) ret += at<DIR>(line, i).getTile().getLetter();
+        return ret;
+    }
+
+    template <Direction DIR>
+    std::string runAfter(int line, int pos) {
+        std::string ret;
+        for (int i = pos + 1; i < SIZE && occupied<DIR>(line, i); i++) ret += at<DIR>(line, i).getTile().getLetter();
+        return ret;
+    }
+
+    template <Direction DIR>
+    Move scoreWord(const std::string& word, int line, int pos, Rack rack) {
+        Move move;
+        move.length = word.length();
+        move.x = xOf<DIR>(line, pos);
+        move.y = yOf<DIR>(line, pos);
+        move.dir = DIR;
+        move.placed = move.blanks = 0;
+        WordScore score;
+        for (unsigned int i = 0; i < word.length(); i++) {
+            char ch = toupper(word[i]);
+            move.letters[i] = ch;
+            const Cell& cell = at<DIR>(line, pos + i);
+            if (cell.isEmpty()) {
+                move.placed |= 1u << i;
+                int points = tilePoints(ch);
+                if (rack.takeFor(ch) == Rack::BLANK) {
+                    move.blanks |= 1u << i;
+                    points = 0;
+                }
+                score.place(cell, points, crossOf(DIR));
+            } else score.cover(cell);
+        }
+        move.score = score.total();
+        move.equity = move.score;
+        return move;
+    }
+
+    bool isLegal(std::string word, int x, int y, Direction dir, Rack& rack) {
+        int line = dir == Direction::ACROSS ? y : x;
+        int pos = dir == Direction::ACROSS ? x : y;
+        if (word.empty() || line < 0 || line >= SIZE || pos < 0 || pos + word.length() > SIZE) return false;
+        Line span = ((1u << word.length()) - 1) << pos;
+        // the word must place a tile and be the whole run of tiles it is in
+        Line occupied = lines(dir)[line];
+        if ((span & ~occupied) == 0) return false;
+        if (pos > 0 && ((occupied >> (pos - 1)) & 1)) return false;
+        if (pos + word.length() < SIZE && ((occupied >> (pos + word.length())) & 1)) return false;
+        if (empty) {
+            int center_line = dir == Direction::ACROSS ? Layout::CENTER_Y : Layout::CENTER_X;
+            int center_pos = dir == Direction::ACROSS ? Layout::CENTER_X : Layout::CENTER_Y;
+            if (line != center_line || ((span >> center_pos) & 1) == 0) return false;
+        } else if ((span & neighbors(line, dir)) == 0) return false;
+        if (dir == Direction::ACROSS) return isLegalHelper<Direction::ACROSS>(word, 0, line, pos, rack);
+        return isLegalHelper<Direction::DOWN>(word, 0, line, pos, rack);
+    }
+
+public:
+    // words must outlive the board and any copies of it.
+    BasicBoard(const Trie& words) : words(&words), empty(true) {
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) board[y][x].setType(premium(Layout::PREMIUMS[y][x]));
+        }
+    }
+
+    std::string getPrefix(int x, int y, Direction dir) {
+        return dir == Direction::ACROSS ? runBefore<Direction::ACROSS>(y, x) : runBefore<Direction::DOWN>(x, y);
+    }
+
+    std::string getPostfix(int x, int y, Direction dir) {
+        return dir == Direction::ACROSS ? runAfter<Direction::ACROSS>(y, x) : runAfter<Direction::DOWN>(x, y);
+    }
+
+    // Scores word at (x, y) as rack would play it, taking a letter from the
+    // rack when there is one and a blank otherwise. The word must be legal.
+    Move scoreWord(std::string word, int x, int y, Direction dir, Rack rack) {
+        if (dir == Direction::ACROSS) return scoreWord<Direction::ACROSS>(word, y, x, rack);
+        return scoreWord<Direction::DOWN>(word, x, y, rack);
+    }
+
+    int placeWord(std::string word, int x, int y, Direction dir, Rack& rack, bool sandbox) {
+        if (!words->isLegal(word) || !isLegal(word, x, y, dir, rack)) return -1;
+        Move move = scoreWord(word, x, y, dir, rack);
+        if (!sandbox) playMove(move, rack);
+        return move.score;
+    }
+
+    // Plays a move from the move generator, which has already checked and
+    // scored it, taking its tiles off rack. Returns the move's score.
+    int playMove(const Move& move, Rack& rack) { return applyMove(move, rack, false); }
+
+    // Plays a move like playMove, remembering the cells it changed so that
+    // unmakeMove can take it back. Up to MAX_UNDO moves can be pending.
+    int makeMove(const Move& move, Rack& rack) {
+        assert(undo_depth < MAX_UNDO);
+        frames[undo_depth++] = { static_cast<int16_t>(saved_count), empty };
+        return applyMove(move, rack, true);
+    }
+
+    // Takes back the last move made with makeMove, returning its tiles to
+    // rack and restoring the cells and cross-checks exactly as they were.
+    void unmakeMove(Rack& rack) {
+        assert(undo_depth > 0);
+        const UndoFrame& frame = frames[--undo_depth];
+        while (saved_count > frame.saved) {
+            const SavedCell& cell = saved[--saved_count];
+            Cell& current = board[cell.y][cell.x];
+            if (cell.cell.isEmpty() && !current.isEmpty()) {
+                Tile tile = current.getTile();
+                rack.add(tile.getPoints() == 0 ? Rack::BLANK : tile.getLetter());
+                vacate(cell.x, cell.y);
+            }
+            current = cell.cell;
+        }
+        empty = frame.empty;
+    }
+
+    // moves made with makeMove and not yet taken back
+    int undoDepth() const { return undo_depth; }
+
+    Cell* getCell(int x, int y) { return &board[y][x]; }
+
+    const Cell* getCell(int x, int y) const { return &board[y][x]; }
+
+    // The squares of a line that hold tiles, bit pos for position pos along
+    // it: row line for ACROSS, column line for DOWN.
+    Line occupancy(int line, Direction dir) const { return lines(dir)[line]; }
+
+    // Squares of a line with a tile next to them, along the line or across
+    // it, whether or not they hold a tile themselves.
+    Line neighbors(int line, Direction dir) const {
+        Line ret = alongNeighbors(line, dir);
+        if (line > 0) ret |= lines(dir)[line - 1];
+        if (line < SIZE - 1) ret |= lines(dir)[line + 1];
+        return ret;
+    }
+
+    // The empty squares of a line a move can be built from: those next to a
+    // tile, or just the centre square on an empty board.
+    Line anchors(int line, Direction dir) const {
+        if (empty) {
+            if (dir == Direction::ACROSS) return line == Layout::CENTER_Y ? 1u << Layout::CENTER_X : 0;
+            return line == Layout::CENTER_X ? 1u << Layout::CENTER_Y : 0;
+        }
+        return neighbors(line, dir) & ~lines(dir)[line];
+    }
+
+    // placeWord keeps cross-checks up to date itself; this recomputes them
+    // all for a board that was set up some other way.
+    void recomputeValidCrosses() {
+        STAT_TIME(CROSS_UPDATE);
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) {
+                updateValidCrosses(x, y);
+            }
+        }
+    }
+
+    // Sets up a position from one string per row: '.' for an empty square,
+    // a letter for a tile, lowercase for a blank. Returns false, leaving the
+    // board as it was, if rows is not a SIZE x SIZE grid of those.
+    bool loadRows(const std::vector<std::string>& rows) {
+        if (rows.size() != SIZE) return false;
+        for (const std::string& row : rows) {
+            if (row.length() != SIZE) return false;
+            for (char ch : row) {
+                if (ch != '.' && !isalpha(ch)) return false;
+            }
+        }
+        clearTiles();
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) {
+                char ch = rows[y][x];
+                if (ch != '.') putTile(x, y, toupper(ch), islower(ch));
+            }
+        }
+        recomputeValidCrosses();
+        return true;
+    }
+
+    // The inverse of loadRows.
+    std::vector<std::string> toRows() {
+        std::vector<std::string> rows;
+        for (int y = 0; y < SIZE; y++) {
+            std::string row;
+            for (int x = 0; x < SIZE; x++) {
+                const Cell& cell = board[y][x];
+                if (cell.isEmpty()) row += '.';
+                else if (cell.getTile().getPoints() == 0 && tilePoints(cell.getTile().getLetter()) != 0) {
+                    row += tolower(cell.getTile().getLetter());
+                } else row += cell.getTile().getLetter();
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    // The tiles as snapshots hold them: letters[y][x] is the letter on
+    // (x, y), '\0' for none, and bit x of blanks[y] is set for a blank.
+    void saveTiles(char letters[SIZE][SIZE], Line blanks[SIZE]) const {
+        for (int y = 0; y < SIZE; y++) {
+            blanks[y] = 0;
+            for (int x = 0; x < SIZE; x++) {
+                const Cell& cell = board[y][x];
+                letters[y][x] = cell.getTile().getLetter();
+                if (!cell.isEmpty() && cell.getTile().getPoints() == 0 && tilePoints(letters[y][x]) != 0) {
+                    blanks[y] |= 1u << x;
+                }
+            }
+        }
+    }
+
+    // Sets up a position from saveTiles' output. The cross-checks are left
+    // allowing everything, for loadCrosses or recomputeValidCrosses to fill
+    // in. Returns false, leaving the board as it was, if a letter is not A-Z.
+    bool loadTiles(const char letters[SIZE][SIZE], const Line blanks[SIZE]) {
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) {
+                if (letters[y][x] != '\0' && (letters[y][x] < 'A' || letters[y][x] > 'Z')) return false;
+            }
+        }
+        clearTiles();
+        for (int y = 0; y < SIZE; y++) {
+            for (int x = 0; x < SIZE; x++) {
+                if (letters[y][x] != '\0') putTile(x, y, letters[y][x], (blanks[y] >> x) & 1);
+            }
+        }
+        return true;
+    }
+
+    // Every square's cross-check masks and points, indexed [dir][y][x].
+    void saveCrosses(uint32_t masks[2][SIZE][SIZE], int16_t points[2][SIZE][SIZE]) const {
+        for (int dir = 0; dir < 2; dir++) {
+            for (int y = 0; y < SIZE; y++) {
+                for (int x = 0; x < SIZE; x++) {
+                    masks[dir][y][x] = board[y][x].getValidCrosses(Direction(dir));
+                    points[dir][y][x] = board[y][x].getCrossPoints(Direction(dir));
+                }
+            }
+        }
+    }
+
+    // Restores cross-checks saved with saveCrosses for the same tiles, in
+    // place of recomputeValidCrosses.
+    void loadCrosses(const uint32_t masks[2][SIZE][SIZE], const int16_t points[2][SIZE][SIZE]) {
+        for (int dir = 0; dir < 2; dir++) {
+            for (int y = 0; y < SIZE; y++) {
+                for (int x = 0; x < SIZE; x++) {
+                    board[y][x].setValidCrosses(Direction(dir), masks[dir][y][x], points[dir][y][x]);
+                }
+            }
+        }
+    }
+
+    bool isEmpty() { return empty; }
+
+    // The board as text, indented by indent columns.
+    std::string toString(int indent = 0) {
+        std::stringstream blank_line;
+        for (int i = 0; i < 4 + indent; i++) blank_line << " ";
+        for (int i = 0; i < SIZE; i++) {
+            blank_line << "|----";
+        }
+        blank_line << "|" << std::endl;
+
+        std::stringstream ret;
+        for (int i = 0; i < 4 + indent; i++) ret << " ";
+        for (int i = 0; i < SIZE; i++) {
+            ret << "  " << i / 10 << i % 10 << " ";
+        }
+        ret << std::endl;
+        ret << blank_line.str();
+        for (int i = 0; i < SIZE; i++) {
+            for (int i = 0; i < indent; i++) ret << " ";
+            ret << " " << i / 10 << i % 10 << " ";
+            for (int j = 0; j < SIZE; j++) {
+                ret << "|";
+                ret << board[i][j].toString();
+            }
+            ret << "|";
+            ret << std::endl << blank_line.str();
+        }
+        return ret.str();
+    }
+};
+
+using Board = BasicBoard<StandardLayout>;
+using Move = Board::Move;
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "game.h"
+
+// Replays the positions of seeded self-play games and checks that the
+// alternatives the engine has for one job agree: the GADDAG generator with
+// the trie one, generation on a thread pool with generation on one thread,
+// and the cross-checks a move updates as it is played with those recomputed
+// from scratch. Exits non-zero at the first position where they do not.
+
+// Everything a sink is told about a move, as something moves sort by.
+typedef std::tuple<std::string, int, int, int, int, int, int> MoveKey;
+
+MoveKey moveKey(const Move& move) {
+    return MoveKey(move.word(), move.x, move.y, move.dir, move.placed, move.blanks, move.score);
+}
+
+std::vector<MoveKey> moveKeys(const std::vector<Move>& moves, bool sorted) {
+    std::vector<MoveKey> keys;
+    for (const Move& move : moves) keys.push_back(moveKey(move));
+    if (sorted) std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<Move> generate(const Lexicon& lexicon, Board& board, const Rack& rack,
+                           MoveGenerator::Algorithm algorithm, ThreadPool* pool) {
+    MoveBuffer buffer;
+    MoveGenerator(lexicon, board, rack, algorithm).generate(buffer, pool);
+    return buffer.moves;
+}
+
+// Whether board's cross-checks are the ones recomputeValidCrosses gives it.
+bool crossesUpToDate(const Board& board) {
+    static SnapshotCrosses kept, recomputed;
+    Board fresh = board;
+    fresh.recomputeValidCrosses();
+    board.saveCrosses(kept.masks, kept.points);
+    fresh.saveCrosses(recomputed.masks, recomputed.points);
+    return memcmp(&kept, &recomputed, sizeof(kept)) == 0;
+}
+
+bool sameCrosses(const Board& a, const Board& b) {
+    static SnapshotCrosses crosses_a, crosses_b;
+    a.saveCrosses(crosses_a.masks, crosses_a.points);
+    b.saveCrosses(crosses_b.masks, crosses_b.points);
+    return memcmp(&crosses_a, &crosses_b, sizeof(crosses_a)) == 0;
+}
+
+// A move as failure messages name it.
+std::string describe(const Move& move) {
+    return move.word() + " at " + std::to_string(move.x) + "," + std::to_string(move.y) +
+           (move.dir == Direction::ACROSS ? " across" : " down");
+}
+
+int main(int argc, char** argv) {
+    int games = 4;
+    if (argc > 1) {
+        try {
+            games = std::stoi(argv[1]);
+        } catch (const std::logic_error&) {
+            games = 0;
+        }
+        if (argc > 2 || games < 1) {
+            std::cerr << "usage: " << argv[0] << " [GAMES]" << std::endl;
+            return 1;
+        }
+    }
+
+    Lexicon lexicon(true);
+    ThreadPool pool(4);
+    long positions = 0, moves = 0;
+    for (int seed = 1; seed <= games; seed++) {
+        std::vector<Snapshot> snapshots;
+        Game(lexicon, Game::ComputerMode::HARD, MoveGenerator::Algorithm::TRIE, 1, seed)
+            .selfPlay(Game::ComputerMode::HARD, &snapshots);
+
+        Game game(lexicon, MoveGenerator::Algorithm::TRIE);
+        for (size_t turn = 0; turn < snapshots.size(); turn++) {
+            const Snapshot& snapshot = snapshots[turn];
+            game.load(snapshot);
+            Board board = game.getBoard();
+            Rack rack = game.getRack(snapshot.to_move);
+            std::string where = "game " + std::to_string(seed) + " turn " + std::to_string(turn) + ", rack " +
+                                rack.toString() + ":\n" + board.toString();
+
+            std::vector<Move> trie = generate(lexicon, board, rack, MoveGenerator::Algorithm::TRIE, nullptr);
+            std::vector<Move> gaddag = generate(lexicon, board, rack, MoveGenerator::Algorithm::GADDAG, nullptr);
+            if (moveKeys(trie, true) != moveKeys(gaddag, true)) {
+                std::cerr << "GADDAG and trie move sets differ (" << gaddag.size() << " and " << trie.size()
+                          << " moves) in " << where << std::endl;
+                return 1;
+            }
+
+            std::vector<Move> pooled = generate(lexicon, board, rack, MoveGenerator::Algorithm::TRIE, &pool);
+            if (moveKeys(trie, false) != moveKeys(pooled, false)) {
+                std::cerr << "moves generated on the pool differ from the serial ones in " << where << std::endl;
+                return 1;
+            }
+
+            // every move, played for good and made to be taken back
+            const Board original = board;
+            for (const Move& move : trie) {
+                Board played = board;
+                Rack rest = rack;
+                played.playMove(move, rest);
+                if (!crossesUpToDate(played)) {
+                    std::cerr << "playMove left stale cross-checks after " << describe(move) << " in " << where
+                              << std::endl;
+                    return 1;
+                }
+                rest = rack;
+                board.makeMove(move, rest);
+                bool made = sameCrosses(board, played);
+                board.unmakeMove(rest);
+                if (!made) {
+                    std::cerr << "makeMove and playMove disagree on cross-checks after " << describe(move)
+                              << " in " << where << std::endl;
+                    return 1;
+                }
+                if (!sameCrosses(board, original)) {
+                    std::cerr << "unmakeMove did not restore the cross-checks after " << describe(move) << " in "
+                              << where << std::endl;
+                    return 1;
+                }
+            }
+            positions++;
+            moves += trie.size();
+        }
+    }
+    std::cout << "check: " << games << " games, " << positions << " positions, " << moves
+              << " moves, generators, pool and cross-checks agree" << std::endl;
+    return 0;
+}
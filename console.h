@@ -0,0 +1,225 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "game.h"
+#include "render.h"
+
+// Plays a Game against a person at the terminal: draws it through a Screen
+// and reads their moves from standard input. Player 0 is the person and
+// player 1 the computer.
+class ConsoleGame {
+private:
+    Game game;
+    Screen screen;
+    // columns everything is indented by to centre it in the terminal
+    int padding;
+
+    // lines printBoard draws, with prompts going below them
+    static constexpr int FRAME_ROWS = 43;
+
+    // The start of a line of output below the frame, at column 4.
+    void indent() {
+        for (int i = 0; i < 4 + padding; i++) std::cout << " ";
+    }
+
+    // "|----" slots times, closed with a bar.
+    void drawRule(int row, int col, int slots) {
+        std::string line;
+        for (int i = 0; i < slots; i++) line += "|----";
+        screen.text(row, col, line + "|");
+    }
+
+    // A tile's letter then its points, from col.
+    void drawTile(int row, int col, char letter, int points) {
+        screen.text(row, col, letter + std::to_string(points), Screen::Style::TILE);
+    }
+
+    // The four columns after the bar at col: a tile, a premium square's
+    // label or nothing.
+    void drawCell(int row, int col, const Cell& cell) {
+        if (!cell.isEmpty()) {
+            drawTile(row, col + 2, cell.getTile().getLetter(), cell.getTile().getPoints());
+            return;
+        }
+        switch (cell.getType()) {
+            case Cell::Type::DW: {
+                screen.text(row, col + 2, "DW", Screen::Style::DW);
+            } break;
+            case Cell::Type::TW: {
+                screen.text(row, col + 2, "TW", Screen::Style::TW);
+            } break;
+            case Cell::Type::DL: {
+                screen.text(row, col + 2, "DL", Screen::Style::DL);
+            } break;
+            case Cell::Type::TL: {
+                screen.text(row, col + 2, "TL", Screen::Style::TL);
+            } break;
+            default: break;
+        }
+    }
+
+    // Draws the scores, board and rack into the next frame and sends what
+    // changed since the last one.
+    void printBoard(bool show_diff) {
+        screen.clear(FRAME_ROWS, 80 + padding);
+        auto digits = [](int score) {
+            return std::to_string(score / 100) + std::to_string((score / 10) % 10) + std::to_string(score % 10);
+        };
+
+        const std::string title = "SCRABBLE";
+        drawRule(0, 19 + padding, title.length());
+        screen.text(1, padding, "  Your Score: " + digits(game.getScore(0)));
+        for (unsigned int i = 0; i < title.length(); i++) {
+            screen.text(1, 19 + padding + 5 * i, "|");
+            drawTile(1, 21 + padding + 5 * i, title[i], POINTS[title[i] - 'A']);
+        }
+        screen.text(1, 19 + padding + 5 * title.length(), "|  Their Score: " + digits(game.getScore(1)));
+        drawRule(2, 19 + padding, title.length());
+
+        std::string diff_string = "";
+        switch (game.getDifficulty()) {
+            case Game::ComputerMode::EASY: {
+                diff_string = "EASY MODE";
+            } break;
+            case Game::ComputerMode::HARD: {
+                diff_string = "HARD MODE";
+            } break;
+            case Game::ComputerMode::IMPOSSIBLE: {
+                diff_string = "IMPOSSIBLE MODE";
+            } break;
+            case Game::ComputerMode::SIMULATION: {
+                diff_string = "SIMULATION MODE";
+            } break;
+            default: break;
+        }
+        if (show_diff) screen.text(4, padding + (80 - diff_string.length()) / 2, diff_string, Screen::Style::TILE);
+
+        const Board& board = game.getBoard();
+        for (int x = 0; x < Board::SIZE; x++) {
+            screen.text(6, 6 + padding + 5 * x, std::to_string(x / 10) + std::to_string(x % 10));
+        }
+        drawRule(7, 4 + padding, Board::SIZE);
+        for (int y = 0; y < Board::SIZE; y++) {
+            int row = 8 + 2 * y;
+            screen.text(row, 1 + padding, std::to_string(y / 10) + std::to_string(y % 10));
+            for (int x = 0; x < Board::SIZE; x++) {
+                screen.text(row, 4 + padding + 5 * x, "|");
+                drawCell(row, 4 + padding + 5 * x, *board.getCell(x, y));
+            }
+            screen.text(row, 4 + padding + 5 * Board::SIZE, "|");
+            drawRule(row + 1, 4 + padding, Board::SIZE);
+        }
+
+        drawRule(40, 24 + padding, Rack::SIZE);
+        std::string tiles = game.getRack(0).toString();
+        for (int i = 0; i < Rack::SIZE; i++) {
+            screen.text(41, 24 + padding + 5 * i, "|");
+            if (i < static_cast<int>(tiles.length()) && tiles[i] != Rack::BLANK) {
+                drawTile(41, 26 + padding + 5 * i, tiles[i], POINTS[tiles[i] - 'A']);
+            }
+        }
+        screen.text(41, 24 + padding + 5 * Rack::SIZE, "|");
+        drawRule(42, 24 + padding, Rack::SIZE);
+
+        screen.present();
+    }
+
+    // Returns false if the player passed; running out of input counts as
+    // passing.
+    bool humanTurn() {
+        while (true) {
+            indent();
+            std::cout << "Enter a move (word, x, y, direction): ";
+            std::string move;
+            bool read;
+            {
+                STAT_TIME(HUMAN_INPUT);
+                read = static_cast<bool>(getline(std::cin, move));
+            }
+            if (!read || move == "PASS") return false;
+            std::stringstream buf(move);
+            std::string word, sdir;
+            Direction dir;
+            int x = -1, y = -1;
+            buf >> word >> x >> y >> sdir;
+            if (sdir == "D") dir = Direction::DOWN;
+            else if (sdir == "A") dir = Direction::ACROSS;
+            else {
+                indent();
+                std::cout << "Invalid direction, must be [AD]" << std::endl;
+                continue;
+            }
+            if (game.playWord(0, word, x, y, dir) >= 0) return true;
+            indent();
+            std::cout << "Invalid move" << std::endl;
+        }
+    }
+
+    // One human turn and one computer turn. passes counts passes in a row.
+    void round(int& passes) {
+        printBoard(true);
+        passes = humanTurn() ? 0 : passes + 1;
+        STAT_REPORT("human");
+        if (game.isOver(passes)) return;
+        passes = game.computerTurn(1, game.getDifficulty()) ? 0 : passes + 1;
+        STAT_REPORT("computer");
+    }
+
+public:
+    // The game as Game takes it, drawn padding columns from the left.
+    ConsoleGame(const Lexicon& lexicon, MoveGenerator::Algorithm generator, unsigned threads, int padding)
+        : game(lexicon, generator, threads), padding(padding) {}
+
+    Game& getGame() { return game; }
+
+    void play() {
+        printBoard(false);
+
+        indent();
+        std::cout << "What difficulty would you like?" << std::endl;
+        indent();
+        std::cout << "E = Easy, H = Hard, I = Impossible, S = Simulation" << std::endl;
+        bool done = false;
+        while (!done) {
+            indent();
+            std::string d;
+            if (!getline(std::cin, d)) return;
+            done = true;
+            switch (d.empty() ? 0 : toupper(d[0])) {
+                case 'E': game.setDifficulty(Game::ComputerMode::EASY); break;
+                case 'H': game.setDifficulty(Game::ComputerMode::HARD); break;
+                case 'I': game.setDifficulty(Game::ComputerMode::IMPOSSIBLE); break;
+                case 'S': game.setDifficulty(Game::ComputerMode::SIMULATION); break;
+                default: {
+                    indent();
+                    std::cout << "Invalid difficulty, try again." << std::endl;
+                    done = false;
+                } break;
+            }
+        }
+
+        std::cout << std::flush;
+
+        game.deal();
+        int passes = 0;
+        while (!game.isOver(passes)) {
+            round(passes);
+        }
+
+        game.settleRacks();
+
+        printBoard(true);
+
+        for (int i = 0; i < padding; i++) std::cout << " ";
+        if (game.getScore(0) > game.getScore(1)) {
+            std::cout << "You win!" << std::endl;
+        } else if (game.getScore(0) < game.getScore(1)) {
+            std::cout << "You lose!" << std::endl;
+        } else {
+            std::cout << "A tie!" << std::endl;
+        }
+    }
+};
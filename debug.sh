@@ -1,5 +1,5 @@
 #!/bin/sh
 
 git pull
-CC_OPT=-O0 BUILD_DIR=build make clean all
+CC_OPT="-O0 -DVERIFY_CROSSES" BUILD_DIR=build make clean all
 gdb build/scrabble
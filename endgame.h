@@ -0,0 +1,283 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include "movegen.h"
+
+// Random keys for hashing endgame positions: one per tile (letter, and
+// whether it is a blank) on each square, per count of each kind on each
+// rack, for the side to move and for a pending pass.
+struct ZobristKeys {
+    uint64_t tiles[Board::SIZE][Board::SIZE][52];
+    uint64_t racks[2][27][Rack::SIZE + 1];
+    uint64_t side;
+    uint64_t passed;
+
+    ZobristKeys() {
+        std::mt19937_64 rand_engine(0x5c7ab81e);
+        for (auto& row : tiles) {
+            for (auto& square : row) {
+                for (uint64_t& key : square) key = rand_engine();
+            }
+        }
+        for (auto& rack : racks) {
+            for (auto& kind : rack) {
+                for (uint64_t& key : kind) key = rand_engine();
+            }
+        }
+        side = rand_engine();
+        passed = rand_engine();
+    }
+
+    static const ZobristKeys& get() {
+        static const ZobristKeys keys;
+        return keys;
+    }
+};
+
+// Solves the empty-bag endgame, where both racks are known: iterative
+// deepening negamax with alpha-beta over both players' moves and passes,
+// moves tried best score first, and a transposition table keyed by Zobrist
+// hashes. Values are the rest of the game's spread for the side to move,
+// including the rack points settled at the end. Positions at the depth
+// limit count as level; once an iteration never reaches the limit the
+// result is exact.
+class EndgameSolver {
+public:
+    struct Settings {
+        long max_nodes = 2000000;
+        double seconds = 1.0;
+        int max_depth = 16;
+        int table_bits = 18;
+    };
+
+private:
+    enum Bound : int8_t { EXACT = 0, LOWER, UPPER };
+
+    struct Entry {
+        uint64_t key = 0;
+        int32_t value = 0;
+        uint32_t best = 0;  // fingerprint of the best move, 0 for a pass
+        int16_t depth = -1;
+        Bound bound = EXACT;
+        // no position below was cut off by the depth limit
+        bool complete = false;
+    };
+
+    static constexpr int INF = 1 << 20;
+
+    const Lexicon& lexicon;
+    MoveGenerator::Algorithm algorithm;
+    Settings settings;
+    std::vector<Entry> table;
+
+    long nodes = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted = false;
+    bool cut = false;
+
+    static int rackPoints(const Rack& rack) {
+        int ret = 0;
+        for (char ch : rack.toString()) {
+            if (ch != Rack::BLANK) ret += POINTS[ch - 'A'];
+        }
+        return ret;
+    }
+
+    static uint64_t rackKey(const Rack& rack, int player) {
+        const ZobristKeys& keys = ZobristKeys::get();
+        uint64_t ret = 0;
+        for (int kind = 0; kind < 27; kind++) {
+            ret ^= keys.racks[player][kind][rack.count(kind < 26 ? 'A' + kind : Rack::BLANK)];
+        }
+        return ret;
+    }
+
+    static uint64_t boardKey(Board& board) {
+        const ZobristKeys& keys = ZobristKeys::get();
+        uint64_t ret = 0;
+        for (int y = 0; y < Board::SIZE; y++) {
+            for (int x = 0; x < Board::SIZE; x++) {
+                const Cell* cell = board.getCell(x, y);
+                if (cell->isEmpty()) continue;
+                Tile tile = cell->getTile();
+                ret ^= keys.tiles[y][x][tile.getLetter() - 'A' + (tile.getPoints() == 0 ? 26 : 0)];
+            }
+        }
+        return ret;
+    }
+
+    static uint64_t moveKey(const Move& move) {
+        const ZobristKeys& keys = ZobristKeys::get();
+        int dx = move.dir == Direction::ACROSS ? 1 : 0;
+        int dy = move.dir == Direction::DOWN ? 1 : 0;
+        uint64_t ret = 0;
+        for (int i = 0; i < move.length; i++) {
+            if (!move.isPlaced(i)) continue;
+            ret ^= keys.tiles[move.y + i * dy][move.x + i * dx][move.letters[i] - 'A' + (move.isBlank(i) ? 26 : 0)];
+        }
+        return ret;
+    }
+
+    // Identifies a move within a position; never 0, which means a pass.
+    static uint32_t fingerprint(const Move& move) { return static_cast<uint32_t>(moveKey(move) >> 32) | 1; }
+
+    std::vector<Move> orderedMoves(Board& board, const Rack& rack, uint32_t first) {
+        MoveBuffer buffer;
+        MoveGenerator(lexicon, board, rack, algorithm).generate(buffer);
+        std::vector<Move>& moves = buffer.moves;
+        std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) {
+            if (a.score != b.score) return a.score > b.score;
+            return isBetter(a, b);
+        });
+        for (size_t i = 0; first != 0 && i < moves.size(); i++) {
+            if (fingerprint(moves[i]) == first) {
+                std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+                break;
+            }
+        }
+        return moves;
+    }
+
+    bool outOfBudget() {
+        if (++nodes > settings.max_nodes) aborted = true;
+        if ((nodes & 1023) == 0 && std::chrono::steady_clock::now() > deadline) aborted = true;
+        return aborted;
+    }
+
+    // Value for player of playing move: its score less the rest of the game
+    // for the opponent, or plus the rack settlement if it went out.
+    int afterMove(Board& board, Rack racks[2], int player, const Move& move, int depth, int alpha, int beta,
+                  uint64_t board_key) {
+        int opponent = 1 - player;
+        Rack next[2] = { racks[0], racks[1] };
+        board.makeMove(move, next[player]);
+        int value = next[player].empty()
+                        ? move.score + 2 * rackPoints(racks[opponent])
+                        : move.score - search(board, next, opponent, false, depth - 1, -beta, -alpha,
+                                              board_key ^ moveKey(move));
+        board.unmakeMove(next[player]);
+        return value;
+    }
+
+    int afterPass(Board& board, Rack racks[2], int player, bool passed, int depth, int alpha, int beta,
+                  uint64_t board_key) {
+        if (passed) return 2 * (rackPoints(racks[1 - player]) - rackPoints(racks[player]));
+        return -search(board, racks, 1 - player, true, depth - 1, -beta, -alpha, board_key);
+    }
+
+    int search(Board& board, Rack racks[2], int player, bool passed, int depth, int alpha, int beta,
+               uint64_t board_key) {
+        if (outOfBudget()) return 0;
+        if (depth == 0) {
+            cut = true;
+            return 0;
+        }
+
+        const ZobristKeys& keys = ZobristKeys::get();
+        uint64_t key = board_key ^ rackKey(racks[0], 0) ^ rackKey(racks[1], 1) ^ (player ? keys.side : 0) ^
+                       (passed ? keys.passed : 0);
+        Entry& entry = table[key & (table.size() - 1)];
+        uint32_t first = 0;
+        if (entry.key == key) {
+            first = entry.best;
+            if (entry.depth >= depth || entry.complete) {
+                if (!entry.complete) cut = true;
+                if (entry.bound == EXACT) return entry.value;
+                if (entry.bound == LOWER) alpha = std::max(alpha, entry.value);
+                if (entry.bound == UPPER) beta = std::min(beta, entry.value);
+                if (alpha >= beta) return entry.value;
+            }
+        }
+
+        bool outer_cut = cut;
+        cut = false;
+        int original_alpha = alpha;
+        int best = -INF;
+        uint32_t best_move = 0;
+        std::vector<Move> moves = orderedMoves(board, racks[player], first);
+        for (const Move& move : moves) {
+            int value = afterMove(board, racks, player, move, depth, alpha, beta, board_key);
+            if (aborted) return 0;
+            if (value > best) {
+                best = value;
+                best_move = fingerprint(move);
+            }
+            alpha = std::max(alpha, value);
+            if (alpha >= beta) break;
+        }
+        if (alpha < beta) {
+            int value = afterPass(board, racks, player, passed, depth, alpha, beta, board_key);
+            if (aborted) return 0;
+            if (value > best) {
+                best = value;
+                best_move = 0;
+            }
+        }
+
+        entry.key = key;
+        entry.value = best;
+        entry.best = best_move;
+        entry.depth = depth;
+        entry.bound = best <= original_alpha ? UPPER : best >= beta ? LOWER : EXACT;
+        entry.complete = !cut;
+        cut = cut || outer_cut;
+        return best;
+    }
+
+public:
+    EndgameSolver(const Lexicon& lexicon, MoveGenerator::Algorithm algorithm, Settings settings)
+        : lexicon(lexicon), algorithm(algorithm), settings(settings), table(size_t(1) << settings.table_bits) {}
+
+    // Finds the move for player that maximizes their final spread against
+    // best play, within the node and time limits. Sets move and returns
+    // true, or returns false if passing is best. Moves are searched on board
+    // itself with makeMove and taken back, so it is unchanged on return.
+    bool solve(Board& board, const Rack racks[2], int player, Move& move) {
+        int max_depth = std::min(settings.max_depth, Board::MAX_UNDO - board.undoDepth());
+        nodes = 0;
+        aborted = false;
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(settings.seconds));
+        Rack position[2] = { racks[0], racks[1] };
+        uint64_t board_key = boardKey(board);
+
+        std::vector<Move> moves = orderedMoves(board, racks[player], 0);
+        bool found = !moves.empty();
+        if (found) move = moves[0];
+        for (int depth = 1; depth <= max_depth && !moves.empty(); depth++) {
+            cut = false;
+            int alpha = -INF;
+            int best = -INF;
+            const Move* best_move = nullptr;
+            for (const Move& candidate : moves) {
+                int value = afterMove(board, position, player, candidate, depth, alpha, INF, board_key);
+                if (aborted) break;
+                if (value > best) {
+                    best = value;
+                    best_move = &candidate;
+                }
+                alpha = std::max(alpha, value);
+            }
+            if (aborted) break;
+            int pass = afterPass(board, position, player, false, depth, alpha, INF, board_key);
+            if (aborted) break;
+
+            found = pass <= best;
+            if (found) {
+                move = *best_move;
+                // search it first next time
+                auto at = moves.begin() + (best_move - moves.data());
+                std::rotate(moves.begin(), at, at + 1);
+            }
+            if (!cut) break;
+        }
+        return found;
+    }
+
+    long nodeCount() const { return nodes; }
+};
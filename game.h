@@ -0,0 +1,305 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <memory>
+
+#include "movegen.h"
+#include "simulation.h"
+#include "endgame.h"
+#include "snapshot.h"
+
+// The bag of a tile set, shuffled once and drawn from the front. Tilebag
+// holds the standard game's tiles.
+template <typename Tiles>
+class BasicTilebag {
+private:
+    std::deque<char> bag;
+    std::default_random_engine rand_gen;
+
+public:
+    BasicTilebag() : BasicTilebag(std::chrono::system_clock::now().time_since_epoch().count()) {}
+
+    BasicTilebag(unsigned seed) {
+        rand_gen = std::default_random_engine(seed);
+
+        for (int i = 0; i < 27; i++) {
+            for (int j = 0; j < Tiles::COUNTS[i]; j++) bag.push_back(i < 26 ? 'A' + i : Rack::BLANK);
+        }
+
+        std::shuffle(bag.begin(), bag.end(), rand_gen);
+    }
+
+    void draw(Rack& rack, int num) {
+        num = std::min(static_cast<size_t>(num), bag.size());
+        for (int i = 0; i < num; i++) {
+            rack.add(bag.front());
+            bag.pop_front();
+        }
+    }
+
+    size_t size() {
+        return bag.size();
+    }
+
+    void save(Snapshot& snapshot) const {
+        static_assert(bagSize<Tiles>() <= Snapshot::MAX_BAG, "snapshots hold at most MAX_BAG tiles");
+        snapshot.bag_size = bag.size();
+        std::copy(bag.begin(), bag.end(), snapshot.bag);
+        snapshot.bag_engine = engineState(rand_gen);
+    }
+
+    // Returns false, leaving the bag as it was, if snapshot's is not valid.
+    bool load(const Snapshot& snapshot) {
+        if (snapshot.bag_size > Snapshot::MAX_BAG) return false;
+        for (int i = 0; i < snapshot.bag_size; i++) {
+            char ch = snapshot.bag[i];
+            if (ch != Rack::BLANK && (ch < 'A' || ch > 'Z')) return false;
+        }
+        bag.assign(snapshot.bag, snapshot.bag + snapshot.bag_size);
+        setEngineState(rand_gen, snapshot.bag_engine);
+        return true;
+    }
+};
+
+using Tilebag = BasicTilebag<StandardLayout::Tiles>;
+
+// What a headless game leaves behind: final scores and the time each turn
+// took to choose and play its move.
+struct GameRecord {
+    int scores[2];
+    int moves = 0;
+    std::vector<double> latencies;
+};
+
+// The state and rules of one two-player game, with no I/O: the board, bag,
+// racks and scores, and the computer player. Games share nothing but the
+// Lexicon, which is read-only, so any number of them can run at once.
+class Game {
+public:
+    enum ComputerMode { EASY = 0, HARD, IMPOSSIBLE, SIMULATION };
+
+private:
+    const Lexicon& lexicon;
+    Board board;
+    Tilebag bag;
+    int scores[2];
+    Rack racks[2];
+
+    ComputerMode difficulty = ComputerMode::HARD;
+
+    MoveGenerator::Algorithm generator = MoveGenerator::Algorithm::TRIE;
+    std::unique_ptr<ThreadPool> pool;
+    std::default_random_engine rand_engine;
+    Simulator::Settings simulation;
+    EndgameSolver::Settings endgame;
+
+    // EASY and HARD play the best of a random quarter or half of the moves,
+    // IMPOSSIBLE the best of all of them.
+    std::unique_ptr<MoveSelector> makeSelector(ComputerMode mode) {
+        unsigned seed = rand_engine();
+        switch (mode) {
+            case ComputerMode::EASY: return std::make_unique<SampledBestSink>(0.25, seed);
+            case ComputerMode::HARD: return std::make_unique<SampledBestSink>(0.5, seed);
+            default: return std::make_unique<TopKSink>(1);
+        }
+    }
+
+    // The tiles player cannot see: everything not on the board or their rack.
+    std::vector<char> unseen(int player) {
+        int counts[27];
+        std::copy(TILE_COUNTS, TILE_COUNTS + 27, counts);
+        for (int y = 0; y < Board::SIZE; y++) {
+            for (int x = 0; x < Board::SIZE; x++) {
+                const Cell* cell = board.getCell(x, y);
+                if (cell->isEmpty()) continue;
+                counts[cell->getTile().getPoints() == 0 ? 26 : cell->getTile().getLetter() - 'A']--;
+            }
+        }
+        for (char ch : racks[player].toString()) counts[ch == Rack::BLANK ? 26 : ch - 'A']--;
+
+        std::vector<char> ret;
+        for (int i = 0; i < 27; i++) {
+            for (int j = 0; j < counts[i]; j++) ret.push_back(i < 26 ? 'A' + i : Rack::BLANK);
+        }
+        return ret;
+    }
+
+public:
+    // lexicon must outlive the game and have its GADDAG loaded if generator
+    // needs it. threads > 1 generates the computer's moves on a pool of that
+    // many threads; 0 uses one per hardware thread. seed drives the bag and
+    // the computer's move sampling.
+    Game(const Lexicon& lexicon, ComputerMode difficulty, MoveGenerator::Algorithm generator, unsigned threads = 1,
+         unsigned seed = std::chrono::system_clock::now().time_since_epoch().count())
+        : lexicon(lexicon), board(lexicon.words()), bag(seed), difficulty(difficulty), generator(generator),
+          rand_engine(seed) {
+        if (threads != 1) pool = std::make_unique<ThreadPool>(threads);
+        scores[0] = scores[1] = 0;
+        racks[0] = racks[1] = Rack();
+    }
+
+    Game(const Lexicon& lexicon, MoveGenerator::Algorithm generator, unsigned threads = 1)
+        : Game(lexicon, ComputerMode::HARD, generator, threads) {}
+
+    void setSimulation(const Simulator::Settings& settings) { simulation = settings; }
+
+    void setEndgame(const EndgameSolver::Settings& settings) { endgame = settings; }
+
+    void setDifficulty(ComputerMode mode) { difficulty = mode; }
+
+    ComputerMode getDifficulty() const { return difficulty; }
+
+    const Board& getBoard() const { return board; }
+
+    const Rack& getRack(int player) const { return racks[player]; }
+
+    int getScore(int player) const { return scores[player]; }
+
+    // Saves the position with player to_move to play next, and the
+    // cross-checks too if crosses is not null.
+    void save(Snapshot& snapshot, int to_move, SnapshotCrosses* crosses = nullptr) const {
+        // zeroed first so that equal positions save as equal bytes
+        memset(&snapshot, 0, sizeof(snapshot));
+        snapshot.to_move = to_move;
+        board.saveTiles(snapshot.tiles, snapshot.blanks);
+        for (int player = 0; player < 2; player++) {
+            for (int kind = 0; kind < 27; kind++) {
+                snapshot.racks[player][kind] = racks[player].count(kind < 26 ? 'A' + kind : Rack::BLANK);
+            }
+            snapshot.scores[player] = scores[player];
+        }
+        bag.save(snapshot);
+        snapshot.game_engine = engineState(rand_engine);
+        if (crosses != nullptr) board.saveCrosses(crosses->masks, crosses->points);
+    }
+
+    // Restores a position saved with save, taking its cross-checks from
+    // crosses if given and recomputing them otherwise. Whose turn it is is
+    // left to the caller, in snapshot.to_move. The difficulty,
+    // generator and settings stay this game's own. Returns false, leaving
+    // the game in an unspecified state, if the snapshot is not valid.
+    bool load(const Snapshot& snapshot, const SnapshotCrosses* crosses = nullptr) {
+        if (!board.loadTiles(snapshot.tiles, snapshot.blanks) || !bag.load(snapshot)) return false;
+        if (crosses != nullptr) board.loadCrosses(crosses->masks, crosses->points);
+        else board.recomputeValidCrosses();
+        for (int player = 0; player < 2; player++) {
+            int total = 0;
+            for (int kind = 0; kind < 27; kind++) total += snapshot.racks[player][kind];
+            if (total > Rack::SIZE) return false;
+            racks[player] = Rack();
+            for (int kind = 0; kind < 27; kind++) {
+                char tile = kind < 26 ? 'A' + kind : Rack::BLANK;
+                for (int n = 0; n < snapshot.racks[player][kind]; n++) racks[player].add(tile);
+            }
+            scores[player] = snapshot.scores[player];
+        }
+        setEngineState(rand_engine, snapshot.game_engine);
+        return true;
+    }
+
+    // Fills both racks from the bag to start the game.
+    void deal() {
+        bag.draw(racks[0], Rack::SIZE);
+        bag.draw(racks[1], Rack::SIZE);
+    }
+
+    // Plays word for player if it is a legal move for their rack, then
+    // refills the rack. Returns the points scored, or -1 if it is not.
+    int playWord(int player, const std::string& word, int x, int y, Direction dir) {
+        int points;
+        {
+            STAT_TIME(PLACEMENT);
+            points = board.placeWord(word, x, y, dir, racks[player], false);
+        }
+        if (points < 0) return -1;
+        scores[player] += points;
+        bag.draw(racks[player], Rack::SIZE - racks[player].size());
+        return points;
+    }
+
+    // Plays the selected move for player's rack. Returns false if there was
+    // no move to play.
+    bool computerTurn(int player, ComputerMode mode) {
+        Move move;
+        bool found;
+        if (bag.size() == 0 && mode >= ComputerMode::IMPOSSIBLE) {
+            // with the bag empty both racks are known, so search it out
+            STAT_TIME(SELECTION);
+            found = EndgameSolver(lexicon, generator, endgame).solve(board, racks, player, move);
+        } else if (mode == ComputerMode::SIMULATION) {
+            STAT_TIME(SELECTION);
+            Simulator simulator(lexicon, board, racks[player], unseen(player), generator, simulation);
+            found = simulator.choose(move, pool.get(), rand_engine());
+        } else {
+            std::unique_ptr<MoveSelector> selector = makeSelector(mode);
+            {
+                STAT_TIME(GENERATION);
+                MoveGenerator(lexicon, board, racks[player], generator).generate(*selector, pool.get());
+            }
+            STAT_TIME(SELECTION);
+            found = selector->choose(move);
+        }
+        if (!found) return false;
+        {
+            STAT_TIME(PLACEMENT);
+            scores[player] += board.playMove(move, racks[player]);
+        }
+
+        bag.draw(racks[player], Rack::SIZE - racks[player].size());
+        return true;
+    }
+
+    // Without exchanges, two passes in a row leave nothing that can change.
+    bool isOver(int passes) {
+        if (passes >= 2) return true;
+        return bag.size() == 0 && (racks[0].empty() || racks[1].empty());
+    }
+
+    // Moves the value of the tiles left on each rack to the other player.
+    void settleRacks() {
+        for (int player = 0; player < 2; player++) {
+            for (char ch : racks[player].toString()) {
+                if (ch != ' ') {
+                    int points = POINTS[ch - 'A'];
+                    scores[player] -= points;
+                    scores[1 - player] += points;
+                }
+            }
+        }
+    }
+
+    // Plays first (at its own difficulty) against this game's computer
+    // player, with no output. Saves the position before each turn to
+    // positions if it is not null.
+    GameRecord selfPlay(ComputerMode first, std::vector<Snapshot>* positions = nullptr) {
+        ComputerMode modes[2] = { first, difficulty };
+        GameRecord record;
+
+        deal();
+        int passes = 0;
+        for (int player = 0; !isOver(passes); player = 1 - player) {
+            if (positions != nullptr) {
+                positions->emplace_back();
+                save(positions->back(), player);
+            }
+            auto start = std::chrono::steady_clock::now();
+            bool played = computerTurn(player, modes[player]);
+            record.latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            STAT_REPORT(player == 0 ? "p1" : "p2");
+            if (played) {
+                record.moves++;
+                passes = 0;
+            } else {
+                passes++;
+            }
+        }
+        settleRacks();
+
+        record.scores[0] = scores[0];
+        record.scores[1] = scores[1];
+        return record;
+    }
+};
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "movegen.h"
+
+// One turn of a game log in GCG format. A play is written as in the log: a
+// position such as 8H (row 8 from column H, across) or H8 (column H from
+// row 8, down), and the word with '.' for tiles already on the board and
+// lowercase for blanks.
+struct GcgTurn {
+    enum Kind { PLAY = 0, PASS, EXCHANGE, WITHDRAWN };
+
+    Kind kind = Kind::PASS;
+    int player = 0;
+    std::string rack;       // as logged, '?' for a blank; may be empty
+    int x = 0;
+    int y = 0;
+    Direction dir = Direction::ACROSS;
+    std::string word;
+    std::string exchanged;  // the tiles thrown back, if known
+    int score = 0;
+};
+
+// Reads the turns of one GCG game from a stream. Pragmas, notes, challenge
+// bonuses, time penalties and the final rack points carry no position, so
+// they are skipped, as are lines that do not parse. Players are numbered
+// by #player1 and #player2, or by first appearance without them.
+class GcgReader {
+private:
+    std::istream& in;
+    std::vector<std::string> nicks;
+    int skipped = 0;
+
+    int playerOf(const std::string& nick) {
+        auto it = std::find(nicks.begin(), nicks.end(), nick);
+        if (it != nicks.end()) return it - nicks.begin();
+        nicks.push_back(nick);
+        return nicks.size() - 1;
+    }
+
+    static bool parsePosition(const std::string& text, GcgTurn& turn) {
+        if (text.length() < 2) return false;
+        bool down = isalpha(text[0]);
+        std::string column = down ? text.substr(0, 1) : text.substr(text.length() - 1);
+        std::string row = down ? text.substr(1) : text.substr(0, text.length() - 1);
+        if (!isalpha(column[0]) || row.empty() || !std::all_of(row.begin(), row.end(), ::isdigit)) return false;
+        turn.x = toupper(column[0]) - 'A';
+        turn.y = std::stoi(row) - 1;
+        turn.dir = down ? Direction::DOWN : Direction::ACROSS;
+        return turn.x >= 0 && turn.x < Board::SIZE && turn.y >= 0 && turn.y < Board::SIZE;
+    }
+
+    // Parses the part of a move line after "nick:". Returns false for
+    // anything that is not a turn.
+    static bool parseMove(std::istream& fields, GcgTurn& turn) {
+        std::string first, second, points;
+        if (!(fields >> first)) return false;
+        if (first[0] == '(') return false;  // final rack points
+        GcgTurn position;
+        if (first[0] == '-' || isdigit(first[0]) || parsePosition(first, position)) {
+            second = first;  // no rack logged
+        } else {
+            turn.rack = first;
+            if (!(fields >> second)) return false;
+        }
+        if (second[0] == '(') return false;  // challenge bonus or time penalty
+        if (second == "--") {
+            turn.kind = GcgTurn::Kind::WITHDRAWN;
+        } else if (second[0] == '-') {
+            turn.kind = second.length() == 1 ? GcgTurn::Kind::PASS : GcgTurn::Kind::EXCHANGE;
+            turn.exchanged = second.substr(1);
+        } else {
+            turn.kind = GcgTurn::Kind::PLAY;
+            if (!parsePosition(second, turn) || !(fields >> turn.word)) return false;
+        }
+        if (fields >> points) turn.score = atoi(points.c_str());
+        return true;
+    }
+
+public:
+    GcgReader(std::istream& in) : in(in) {}
+
+    // Reads the next turn. Returns false at the end of the game.
+    bool next(GcgTurn& turn) {
+        for (std::string line; getline(in, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::stringstream fields(line);
+            std::string tag;
+            if (!(fields >> tag)) continue;
+            if (tag == "#player1" || tag == "#player2") {
+                std::string nick;
+                if (fields >> nick) {
+                    size_t idx = tag[7] - '1';
+                    if (nicks.size() <= idx) nicks.resize(idx + 1);
+                    nicks[idx] = nick;
+                }
+                continue;
+            }
+            if (tag[0] != '>' || tag.back() != ':') continue;
+            turn = GcgTurn();
+            turn.player = playerOf(tag.substr(1, tag.length() - 2));
+            if (parseMove(fields, turn)) return true;
+            if (turn.kind == GcgTurn::Kind::PLAY) skipped++;
+        }
+        return false;
+    }
+
+    // plays that could not be parsed
+    int skippedCount() const { return skipped; }
+};
+
+// What the engine makes of one turn: the move played and the best move by
+// equity in the position before it, and how the played move ranks among
+// all the moves generated there (1 = best; ties share a rank).
+struct TurnAnalysis {
+    int turn;
+    GcgTurn played;
+    // the played move on the board, if it was a play
+    Move move;
+    // whether the rack was known, so moves could be generated
+    bool analyzed = false;
+    // whether the played move was one of them, i.e. legal for its rack
+    bool generated = false;
+    float played_equity = 0;
+    size_t rank = 0;
+    size_t moves = 0;
+    bool has_best = false;
+    Move best;
+
+    float equityLost() const { return has_best ? best.equity - played_equity : 0.0f; }
+};
+
+// Keeps what analyzing a position needs from its moves: the best one, the
+// played one if it comes up, and every move's equity to rank it against.
+// A one-tile play that makes words both ways is generated once per
+// direction; it is counted once, and matches the played move either way.
+class RankSink : public MoveSink {
+public:
+    const Move* target;
+    int target_key;
+    bool found = false;
+    Move played;
+    bool has_best = false;
+    Move best;
+    std::vector<float> equities;
+    // singleKey of every one-tile play seen
+    std::unordered_set<int> singles;
+
+    static bool sameMove(const Move& a, const Move& b) {
+        return a.dir == b.dir && a.x == b.x && a.y == b.y && a.length == b.length && a.placed == b.placed &&
+               a.blanks == b.blanks && memcmp(a.letters, b.letters, a.length) == 0;
+    }
+
+    // The square and tile of a one-tile play as one number, or -1 for a
+    // play of more tiles.
+    static int singleKey(const Move& move) {
+        if (__builtin_popcount(move.placed) != 1) return -1;
+        int i = __builtin_ctz(move.placed);
+        int x = move.x + (move.dir == Direction::ACROSS ? i : 0);
+        int y = move.y + (move.dir == Direction::DOWN ? i : 0);
+        return ((y * Board::SIZE + x) * 26 + move.letters[i] - 'A') * 2 + move.isBlank(i);
+    }
+
+    // target, if not null, is the played move to look out for.
+    RankSink(const Move* target) : target(target), target_key(target != nullptr ? singleKey(*target) : -1) {}
+
+    void add(const Move& move) override {
+        int key = singleKey(move);
+        if (key >= 0 && !singles.insert(key).second) return;
+        equities.push_back(move.equity);
+        if (!has_best || isBetter(move, best)) {
+            best = move;
+            has_best = true;
+        }
+        if (target != nullptr && !found && (key >= 0 ? key == target_key : sameMove(move, *target))) {
+            played = move;
+            found = true;
+        }
+    }
+};
+
+// Replays a game turn by turn from the empty board, analyzing each position
+// before playing the logged move into it.
+class GameAnalyzer {
+private:
+    const Lexicon& lexicon;
+    MoveGenerator::Algorithm algorithm;
+    Board board;
+    // the board before the last play, for when it is withdrawn
+    Board previous;
+    int turns = 0;
+
+    static bool parseRack(const std::string& text, Rack& rack) {
+        if (text.length() > Rack::SIZE) return false;
+        for (char ch : text) {
+            if (ch == '?') rack.add(Rack::BLANK);
+            else if (isalpha(ch)) rack.add(toupper(ch));
+            else return false;
+        }
+        return true;
+    }
+
+    // The logged play as a Move on this board, or false if it does not fit.
+    bool toMove(const GcgTurn& turn, Move& move) {
+        int length = turn.word.length();
+        int start = turn.dir == Direction::ACROSS ? turn.x : turn.y;
+        if (length == 0 || start + length > Board::SIZE) return false;
+        move.length = length;
+        move.x = turn.x;
+        move.y = turn.y;
+        move.dir = turn.dir;
+        move.placed = move.blanks = 0;
+        for (int i = 0; i < length; i++) {
+            const Cell* cell = board.getCell(turn.x + (turn.dir == Direction::ACROSS ? i : 0),
+                                             turn.y + (turn.dir == Direction::DOWN ? i : 0));
+            char ch = turn.word[i];
+            if (!cell->isEmpty()) {
+                if (ch != '.' && toupper(ch) != cell->getTile().getLetter()) return false;
+                move.letters[i] = cell->getTile().getLetter();
+                continue;
+            }
+            if (!isalpha(ch)) return false;
+            move.letters[i] = toupper(ch);
+            move.placed |= 1u << i;
+            if (islower(ch)) move.blanks |= 1u << i;
+        }
+        move.score = turn.score;
+        move.equity = turn.score;
+        return move.placed != 0;
+    }
+
+    // The tiles a move takes from the rack, '?' for a blank.
+    static std::string placedTiles(const Move& move) {
+        std::string ret;
+        for (int i = 0; i < move.length; i++) {
+            if (move.isPlaced(i)) ret += move.isBlank(i) ? '?' : move.letters[i];
+        }
+        return ret;
+    }
+
+    // Score plus the value of what rack keeps after giving up tiles ('?'
+    // for a blank), as the generator values a move. Just the score if rack
+    // lacks any of them.
+    float equityOf(int score, Rack rack, const std::string& tiles) {
+        for (char ch : tiles) {
+            char tile = ch == '?' ? Rack::BLANK : toupper(ch);
+            if (!rack.has(tile)) return score;
+            rack.take(tile);
+        }
+        const LeaveTable* leaves = lexicon.leaves();
+        return score + (leaves != nullptr ? leaves->value(rack) : 0.0f);
+    }
+
+public:
+    // lexicon must outlive the analyzer and have its GADDAG loaded for
+    // Algorithm::GADDAG.
+    GameAnalyzer(const Lexicon& lexicon, MoveGenerator::Algorithm algorithm)
+        : lexicon(lexicon), algorithm(algorithm), board(lexicon.words()), previous(lexicon.words()) {}
+
+    // Analyzes the position the turn was played in, then plays it. Returns
+    // false, changing nothing, for a play that does not fit the board.
+    bool analyze(const GcgTurn& turn, TurnAnalysis& analysis) {
+        analysis = TurnAnalysis();
+        analysis.turn = turns;
+        analysis.played = turn;
+        if (turn.kind == GcgTurn::Kind::WITHDRAWN) {
+            board = previous;
+            turns++;
+            return true;
+        }
+        if (turn.kind == GcgTurn::Kind::PLAY && !toMove(turn, analysis.move)) return false;
+        turns++;
+
+        Rack rack;
+        if (!turn.rack.empty() && parseRack(turn.rack, rack)) {
+            RankSink sink(turn.kind == GcgTurn::Kind::PLAY ? &analysis.move : nullptr);
+            MoveGenerator(lexicon, board, rack, algorithm).generate(sink);
+            analysis.analyzed = true;
+            analysis.moves = sink.equities.size();
+            analysis.has_best = sink.has_best;
+            analysis.best = sink.best;
+            if (sink.found) {
+                analysis.generated = true;
+                analysis.move.score = sink.played.score;
+                analysis.move.equity = sink.played.equity;
+                analysis.played_equity = sink.played.equity;
+            } else if (turn.kind == GcgTurn::Kind::PLAY) {
+                analysis.played_equity = equityOf(turn.score, rack, placedTiles(analysis.move));
+            } else {
+                analysis.played_equity = equityOf(0, rack, turn.exchanged);
+            }
+            analysis.rank = 1;
+            for (float equity : sink.equities) analysis.rank += equity > analysis.played_equity;
+        }
+
+        if (turn.kind == GcgTurn::Kind::PLAY) {
+            previous = board;
+            // the logged tiles, whatever the logged rack said
+            Rack tiles;
+            for (char ch : placedTiles(analysis.move)) tiles.add(ch == '?' ? Rack::BLANK : ch);
+            board.playMove(analysis.move, tiles);
+        }
+        return true;
+    }
+
+    Board& getBoard() { return board; }
+};
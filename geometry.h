@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// Board geometries and tile sets, as compile-time parameters of the board,
+// the move generator and the bag. Each geometry is a separate instantiation,
+// so its size, line masks and loop bounds are all constants.
+
+// The tile set of the standard game: the points of each letter A to Z, and
+// how many of each tile the bag starts with, A to Z and then blanks.
+struct EnglishTiles {
+    static constexpr int POINTS[26] = {
+        1, 3, 3, 2, 1, 4, 2, 4, 1, 8, 5, 1, 3, 1, 1, 3, 10, 1, 1, 1, 1, 4, 4, 8, 4, 10
+    };
+
+    static constexpr int COUNTS[27] = {
+        9, 2, 2, 4, 12, 2, 3, 2, 9, 1, 1, 4, 2, 6, 8, 2, 1, 6, 4, 6, 4, 2, 2, 1, 2, 1, 2
+    };
+};
+
+// Super Scrabble's 200 tiles, at the standard points.
+struct SuperTiles : EnglishTiles {
+    static constexpr int COUNTS[27] = {
+        16, 4, 6, 8, 24, 4, 5, 5, 13, 2, 2, 7, 6, 13, 15, 4, 2, 13, 10, 15, 7, 3, 4, 2, 4, 2, 4
+    };
+};
+
+// how many tiles a full bag of a tile set holds
+template <typename Tiles>
+constexpr int bagSize() {
+    int ret = 0;
+    for (int count : Tiles::COUNTS) ret += count;
+    return ret;
+}
+
+// The bitmask type for the squares of one line, bit pos for position pos.
+template <int SIZE>
+using LineMask = typename std::conditional<SIZE <= 16, uint16_t, uint32_t>::type;
+
+// A layout is a square board of SIZE lines, its premium squares as one
+// string per row, the centre square the first move must cover, and the tile
+// set played on it. In PREMIUMS, '.' is a plain square, 'd' and 't' double
+// and triple letter, and 'D' and 'T' double and triple word.
+
+// The standard 15x15 board.
+struct StandardLayout {
+    static constexpr int SIZE = 15;
+    static constexpr int CENTER_X = 7;
+    static constexpr int CENTER_Y = 7;
+    using Tiles = EnglishTiles;
+
+    static constexpr const char* PREMIUMS[SIZE] = {
+        "T..d...T...d..T",
+        ".D...t...t...D.",
+        "..D...d.d...D..",
+        "d..D...d...D..d",
+        "....D.....D....",
+        ".t...t...t...t.",
+        "..d...d.d...d..",
+        "T..d...D...d..T",
+        "..d...d.d...d..",
+        ".t...t...t...t.",
+        "....D.....D....",
+        "d..D...d...D..d",
+        "..D...d.d...D..",
+        ".D...t...t...D.",
+        "T..d...T...d..T",
+    };
+};
+
+// A 21x21 board with the Super Scrabble tile set. Cells have no quadruple
+// premiums, so this is our own layout in the style of the standard one, not
+// the published Super Scrabble board.
+struct SuperLayout {
+    static constexpr int SIZE = 21;
+    static constexpr int CENTER_X = 10;
+    static constexpr int CENTER_Y = 10;
+    using Tiles = SuperTiles;
+
+    static constexpr const char* PREMIUMS[SIZE] = {
+        "T..d...T..d..T...d..T",
+        ".D...t.........t...D.",
+        "..D...d.......d...D..",
+        "d..D......t......D..d",
+        "....D...t...t...D....",
+        ".t...D...d.d...D...t.",
+        "..d...t.......t...d..",
+        "T......d.....d......T",
+        "....t...t...t...t....",
+        ".....d...d.d...d.....",
+        "d..t......D......t..d",
+        ".....d...d.d...d.....",
+        "....t...t...t...t....",
+        "T......d.....d......T",
+        "..d...t.......t...d..",
+        ".t...D...d.d...D...t.",
+        "....D...t...t...D....",
+        "d..D......t......D..d",
+        "..D...d.......d...D..",
+        ".D...t.........t...D.",
+        "T..d...T..d..T...d..T",
+    };
+};
+
+// A small 9x9 board for practice and quick tests.
+struct PracticeLayout {
+    static constexpr int SIZE = 9;
+    static constexpr int CENTER_X = 4;
+    static constexpr int CENTER_Y = 4;
+    using Tiles = EnglishTiles;
+
+    static constexpr const char* PREMIUMS[SIZE] = {
+        "T..d.d..T",
+        ".D..t..D.",
+        "..D...D..",
+        "d..d.d..d",
+        ".t..D..t.",
+        "d..d.d..d",
+        "..D...D..",
+        ".D..t..D.",
+        "T..d.d..T",
+    };
+};
+
+// Whether a layout is one the board can be built on: every row SIZE squares
+// of known premiums, the centre on the board, and lines shorter than 32
+// squares, since masks are built by shifting 1u by up to a line's length.
+template <typename Layout>
+constexpr bool validLayout() {
+    if (Layout::SIZE < 2 || Layout::SIZE > 31) return false;
+    if (Layout::CENTER_X < 0 || Layout::CENTER_X >= Layout::SIZE) return false;
+    if (Layout::CENTER_Y < 0 || Layout::CENTER_Y >= Layout::SIZE) return false;
+    for (const char* row : Layout::PREMIUMS) {
+        int length = 0;
+        for (; row[length] != '\0'; length++) {
+            char ch = row[length];
+            if (ch != '.' && ch != 'd' && ch != 't' && ch != 'D' && ch != 'T') return false;
+        }
+        if (length != Layout::SIZE) return false;
+    }
+    return true;
+}
+
+// The standard game's tiles, which the rest of the engine plays with.
+constexpr const int (&POINTS)[26] = StandardLayout::Tiles::POINTS;
+constexpr const int (&TILE_COUNTS)[27] = StandardLayout::Tiles::COUNTS;
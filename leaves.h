@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "board.h"
+
+// Value in points of the tiles kept on a rack after a move, for every
+// multiset of up to MAX_TILES tiles (A-Z and the blank). Multisets are
+// numbered by a perfect hash of the rack counts, the combinatorial number
+// system over multisets, so a lookup is a few table reads and adds.
+//
+// The file format is a LeaveHeader followed by size() floats in rank order.
+// mkleaves fits the values by self-play.
+struct LeaveHeader {
+    static constexpr char MAGIC[8] = { 'S', 'C', 'R', 'B', 'L', 'E', 'A', 'V' };
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t entries;
+};
+
+// Binomial coefficients and the rank offsets of each rack size, for at
+// most MAX_TILES tiles of KINDS kinds.
+struct LeaveBinomials {
+    static constexpr int MAX_TILES = 6;
+    static constexpr int KINDS = 27;
+    static constexpr int MAX_N = KINDS + MAX_TILES;
+
+    uint32_t c[MAX_N + 1][MAX_TILES + 1];
+    // offsets[k] is the rank of the first multiset of k tiles
+    uint32_t offsets[MAX_TILES + 2];
+
+    constexpr LeaveBinomials() : c(), offsets() {
+        for (int n = 0; n <= MAX_N; n++) {
+            c[n][0] = 1;
+            for (int k = 1; k <= MAX_TILES; k++) c[n][k] = n == 0 ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+        }
+        for (int k = 0; k <= MAX_TILES; k++) offsets[k + 1] = offsets[k] + c[KINDS + k - 1][k];
+    }
+};
+
+class LeaveTable {
+public:
+    static constexpr int MAX_TILES = LeaveBinomials::MAX_TILES;
+    static constexpr int KINDS = LeaveBinomials::KINDS;
+
+private:
+    static constexpr LeaveBinomials BINOMIALS = LeaveBinomials();
+
+    std::vector<float> values;
+
+    static char tileOf(int kind) { return kind < 26 ? 'A' + kind : Rack::BLANK; }
+
+    template <typename Visit>
+    static void forEachFrom(int kind, Rack& rack, Visit& visit) {
+        visit(rank(rack), static_cast<const Rack&>(rack));
+        if (rack.size() == MAX_TILES) return;
+        for (int next = kind; next < KINDS; next++) {
+            rack.add(tileOf(next));
+            forEachFrom(next, rack, visit);
+            rack.take(tileOf(next));
+        }
+    }
+
+public:
+    LeaveTable() : values(size(), 0.0f) {}
+
+    // number of multisets of at most MAX_TILES tiles
+    static constexpr size_t size() { return BINOMIALS.offsets[MAX_TILES + 1]; }
+
+    // The multiset's index in [0, size()). With its tiles sorted by kind as
+    // t_0 <= ... <= t_{k-1}, that is offsets[k] plus the sum of
+    // C(t_i + i, i + 1). rack must hold at most MAX_TILES tiles.
+    static size_t rank(const Rack& rack) {
+        size_t ret = BINOMIALS.offsets[rack.size()];
+        int i = 0;
+        uint32_t kinds = rack.tileMask();
+        while (kinds != 0) {
+            int kind = __builtin_ctz(kinds);
+            kinds &= kinds - 1;
+            for (int n = rack.count(tileOf(kind)); n > 0; n--, i++) ret += BINOMIALS.c[kind + i][i + 1];
+        }
+        return ret;
+    }
+
+    // Calls visit(rank, rack) once for every multiset.
+    template <typename Visit>
+    static void forEach(Visit visit) {
+        Rack rack;
+        forEachFrom(0, rack, visit);
+    }
+
+    float value(const Rack& rack) const { return rack.size() > MAX_TILES ? 0.0f : values[rank(rack)]; }
+
+    float& operator[](size_t rank) { return values[rank]; }
+
+    bool load(std::string filename) {
+        std::ifstream fin(filename, std::ios::binary);
+        LeaveHeader header;
+        if (!fin.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (memcmp(header.magic, LeaveHeader::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != LeaveHeader::VERSION || header.entries != size()) {
+            std::cerr << filename << ": not a leave table for this build" << std::endl;
+            return false;
+        }
+        return static_cast<bool>(fin.read(reinterpret_cast<char*>(values.data()), size() * sizeof(float)));
+    }
+
+    bool save(std::string filename) const {
+        LeaveHeader header;
+        memcpy(header.magic, LeaveHeader::MAGIC, sizeof(header.magic));
+        header.version = LeaveHeader::VERSION;
+        header.entries = size();
+        std::ofstream fout(filename, std::ios::binary);
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(values.data()), size() * sizeof(float));
+        return fout.good();
+    }
+};
+
+// Returns the table in filename, or nullptr if there is none.
+inline std::unique_ptr<LeaveTable> loadLeaves(std::string filename) {
+    std::ifstream exists(filename);
+    if (!exists.good()) return nullptr;
+    std::unique_ptr<LeaveTable> table = std::make_unique<LeaveTable>();
+    if (!table->load(filename)) return nullptr;
+    return table;
+}
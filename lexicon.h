@@ -0,0 +1,55 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "trie.h"
+#include "leaves.h"
+
+// Everything games look words and leaves up in: the DAWG, the GADDAG if the
+// GADDAG generator is wanted, and the leave table if there is one. Nothing
+// in it changes once loaded, so one Lexicon can be shared by any number of
+// games on any number of threads. It must outlive them.
+class Lexicon {
+private:
+    std::unique_ptr<Trie> dawg;
+    std::unique_ptr<Trie> gaddag;
+    std::unique_ptr<LeaveTable> leave_table;
+
+    // The compiled file when mklex has built it, the word list otherwise or
+    // if the compiled file is stale.
+    static std::unique_ptr<Trie> load(const std::string& compiled, Trie::Kind kind) {
+        std::ifstream exists(compiled);
+        if (exists.good()) {
+            try {
+                return std::make_unique<Trie>(compiled, kind);
+            } catch (const std::runtime_error& e) {
+                std::cerr << e.what() << "; using dict.txt" << std::endl;
+            }
+        }
+        return std::make_unique<Trie>("dict.txt", kind);
+    }
+
+public:
+    // Loads dict.lex, and dict.gdg if with_gaddag, falling back to dict.txt
+    // for either. The leave table comes from leaves_file; an empty name or a
+    // missing file means moves are valued by score alone.
+    Lexicon(bool with_gaddag, const std::string& leaves_file = "leaves.bin") : dawg(load("dict.lex", Trie::Kind::DAWG)) {
+        if (with_gaddag) gaddag = load("dict.gdg", Trie::Kind::GADDAG);
+        if (!leaves_file.empty()) leave_table = loadLeaves(leaves_file);
+    }
+
+    Lexicon(const Lexicon&) = delete;
+    Lexicon& operator=(const Lexicon&) = delete;
+
+    const Trie& words() const { return *dawg; }
+
+    // nullptr unless loaded with_gaddag
+    const Trie* gaddagWords() const { return gaddag.get(); }
+
+    // nullptr without a leave table
+    const LeaveTable* leaves() const { return leave_table.get(); }
+};
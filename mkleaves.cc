@@ -0,0 +1,178 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+#include "game.h"
+#include "thread_pool.h"
+
+// One move made while there were tiles left to draw: the tiles kept, and
+// the points the same player scored on their next turn (0 for a pass).
+struct Observation {
+    Rack leave;
+    int next_score;
+};
+
+// Plays one game with both sides making their best move by equity and
+// records the leave of each move that has a next turn.
+std::vector<Observation> playGame(const Lexicon& lexicon, unsigned seed) {
+    Board board(lexicon.words());
+    Tilebag bag(seed);
+    Rack racks[2];
+    bag.draw(racks[0], Rack::SIZE);
+    bag.draw(racks[1], Rack::SIZE);
+
+    std::vector<Observation> observations;
+    int pending[2] = { -1, -1 };
+    int passes = 0;
+    for (int player = 0; passes < 2 && (bag.size() > 0 || (!racks[0].empty() && !racks[1].empty()));
+         player = 1 - player) {
+        TopKSink best(1);
+        MoveGenerator(lexicon, board, racks[player], MoveGenerator::Algorithm::TRIE).generate(best);
+        Move move;
+        bool found = best.choose(move);
+        if (pending[player] >= 0) observations[pending[player]].next_score = found ? move.score : 0;
+        pending[player] = -1;
+        if (!found) {
+            passes++;
+            continue;
+        }
+        passes = 0;
+        board.playMove(move, racks[player]);
+        if (bag.size() > 0) {
+            observations.push_back({ racks[player], -1 });
+            pending[player] = observations.size() - 1;
+        }
+        bag.draw(racks[player], Rack::SIZE - racks[player].size());
+    }
+
+    std::vector<Observation> ret;
+    for (const Observation& observation : observations) {
+        if (observation.next_score >= 0) ret.push_back(observation);
+    }
+    return ret;
+}
+
+// Solves a x = b in place by Gaussian elimination with partial pivoting.
+void solve(std::vector<std::vector<double>>& a, std::vector<double>& b) {
+    int n = b.size();
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) pivot = row;
+        }
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (int row = 0; row < n; row++) {
+            if (row == col || a[col][col] == 0) continue;
+            double factor = a[row][col] / a[col][col];
+            for (int k = col; k < n; k++) a[row][k] -= factor * a[col][k];
+            b[row] -= factor * b[col];
+        }
+    }
+    for (int i = 0; i < n; i++) b[i] = a[i][i] == 0 ? 0 : b[i] / a[i][i];
+}
+
+// Fits a leave table to self-play: a leave is worth how much more than
+// average its owner scores next turn. A per-tile linear fit gives every
+// leave a prior value, and leaves seen often enough move from it towards
+// their own observed average.
+int main(int argc, char** argv) {
+    int games = 2000;
+    unsigned seed = 1;
+    unsigned threads = 0;
+    std::string in;
+    int arg = 1;
+    for (; arg < argc - 1; arg++) {
+        std::string opt = argv[arg];
+        if (opt == "-n") games = std::stoi(argv[++arg]);
+        else if (opt == "-s") seed = std::stoul(argv[++arg]);
+        else if (opt == "-t") threads = std::stoul(argv[++arg]);
+        else if (opt == "-i") in = argv[++arg];
+        else break;
+    }
+    if (argc - arg != 1) {
+        std::cerr << "usage: " << argv[0] << " [-n games] [-s seed] [-t threads] [-i in.bin] <out.bin>" << std::endl;
+        std::cerr << "  -i  choose self-play moves with an existing table, to refine it" << std::endl;
+        return 1;
+    }
+    std::string out = argv[arg];
+
+    auto start = std::chrono::steady_clock::now();
+    Lexicon lexicon(false, in);
+    if (!in.empty() && lexicon.leaves() == nullptr) {
+        std::cerr << "could not read " << in << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<Observation>> per_game(games);
+    {
+        ThreadPool pool(threads);
+        pool.parallelFor(games, [&](size_t i) { per_game[i] = playGame(lexicon, seed + i); });
+    }
+    std::vector<Observation> observations;
+    for (const std::vector<Observation>& game : per_game) {
+        observations.insert(observations.end(), game.begin(), game.end());
+    }
+    if (observations.empty()) {
+        std::cerr << "no observations" << std::endl;
+        return 1;
+    }
+
+    double mean = 0;
+    for (const Observation& observation : observations) mean += observation.next_score;
+    mean /= observations.size();
+
+    // ridge regression of next_score - mean on the tile counts of the leave
+    const int KINDS = LeaveTable::KINDS;
+    auto countOf = [](const Rack& rack, int kind) { return rack.count(kind < 26 ? 'A' + kind : Rack::BLANK); };
+    std::vector<std::vector<double>> a(KINDS, std::vector<double>(KINDS, 0));
+    std::vector<double> b(KINDS, 0);
+    for (int i = 0; i < KINDS; i++) a[i][i] = 1;
+    for (const Observation& observation : observations) {
+        for (int i = 0; i < KINDS; i++) {
+            int ci = countOf(observation.leave, i);
+            if (ci == 0) continue;
+            b[i] += ci * (observation.next_score - mean);
+            for (int j = 0; j < KINDS; j++) a[i][j] += ci * countOf(observation.leave, j);
+        }
+    }
+    solve(a, b);
+    auto prior = [&](const Rack& rack) {
+        double ret = 0;
+        for (int i = 0; i < KINDS; i++) ret += countOf(rack, i) * b[i];
+        return ret;
+    };
+
+    // observed residuals per leave, shrunk towards the prior by SHRINK
+    // phantom observations
+    const double SHRINK = 20;
+    std::vector<double> residuals(LeaveTable::size(), 0);
+    std::vector<int> seen(LeaveTable::size(), 0);
+    for (const Observation& observation : observations) {
+        size_t rank = LeaveTable::rank(observation.leave);
+        residuals[rank] += observation.next_score - mean - prior(observation.leave);
+        seen[rank]++;
+    }
+    LeaveTable table;
+    size_t distinct = 0;
+    LeaveTable::forEach([&](size_t rank, const Rack& rack) {
+        table[rank] = prior(rack) + residuals[rank] / (seen[rank] + SHRINK);
+        if (seen[rank] > 0) distinct++;
+    });
+    if (!table.save(out)) {
+        std::cerr << "could not write " << out << std::endl;
+        return 1;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << out << ": " << games << " games, " << observations.size() << " leaves (" << distinct
+              << " distinct), mean next score " << mean << ", built in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms" << std::endl;
+    std::cout << "tile values:";
+    for (int i = 0; i < KINDS; i++) {
+        std::cout << " " << (i < 26 ? static_cast<char>('A' + i) : '?') << "=" << std::round(b[i] * 10) / 10;
+    }
+    std::cout << std::endl;
+    return 0;
+}
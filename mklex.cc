@@ -0,0 +1,39 @@
+#include <iostream>
+#include <chrono>
+
+#include "trie.h"
+
+// Compiles a word list into a binary lexicon that Trie maps at startup.
+int main(int argc, char** argv) {
+    Trie::Kind kind = Trie::Kind::DAWG;
+    int arg = 1;
+    if (argc > 1 && std::string(argv[1]) == "-g") {
+        kind = Trie::Kind::GADDAG;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        std::cerr << "usage: " << argv[0] << " [-g] <words.txt> <out.lex>" << std::endl;
+        std::cerr << "  -g  compile a GADDAG instead of a DAWG" << std::endl;
+        return 1;
+    }
+    std::string in = argv[arg];
+    std::string out = argv[arg + 1];
+
+    auto start = std::chrono::steady_clock::now();
+    Trie trie(in, kind);
+    if (trie.isMapped()) {
+        std::cerr << in << " is already a compiled lexicon" << std::endl;
+        return 1;
+    }
+    if (!trie.save(out)) {
+        std::cerr << "could not write " << out << std::endl;
+        return 1;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << out << ": " << trie.nodeCount() << " states, "
+              << trie.byteSize() << " bytes, built in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+              << " ms" << std::endl;
+    return 0;
+}
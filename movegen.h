@@ -0,0 +1,503 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstring>
+
+#include "board.h"
+#include "lexicon.h"
+#include "thread_pool.h"
+
+// Orders moves for selection: higher equity first (just the score without a
+// leave table), then higher score, then a fixed order on
+// position and letters so that ties are broken the same way whatever order
+// the moves were generated in.
+template <typename Layout>
+bool isBetter(const BasicMove<Layout>& a, const BasicMove<Layout>& b) {
+    if (a.equity != b.equity) return a.equity > b.equity;
+    if (a.score != b.score) return a.score > b.score;
+    if (a.dir != b.dir) return a.dir < b.dir;
+    if (a.y != b.y) return a.y < b.y;
+    if (a.x != b.x) return a.x < b.x;
+    if (a.length != b.length) return a.length < b.length;
+    int cmp = memcmp(a.letters, b.letters, a.length);
+    if (cmp != 0) return cmp < 0;
+    return a.blanks < b.blanks;
+}
+
+// Receives moves as the generator produces them, so callers can select
+// without materializing the full move list. The sinks are templates on the
+// layout, like the moves they take; MoveSink and the rest are the standard
+// board's.
+template <typename Layout>
+class BasicMoveSink {
+public:
+    using Move = BasicMove<Layout>;
+
+    virtual ~BasicMoveSink() {}
+
+    virtual void add(const Move& move) = 0;
+};
+
+// Holds moves in generation order, for handing them on to another sink later.
+template <typename Layout>
+class BasicMoveBuffer : public BasicMoveSink<Layout> {
+public:
+    using Move = BasicMove<Layout>;
+
+    std::vector<Move> moves;
+
+    void add(const Move& move) override { moves.push_back(move); }
+};
+
+// A sink that ends in a single choice, one per computer difficulty.
+template <typename Layout>
+class BasicMoveSelector : public BasicMoveSink<Layout> {
+public:
+    using Move = BasicMove<Layout>;
+
+    // Sets move to the selected move. Returns false if there was none.
+    virtual bool choose(Move& move) const = 0;
+};
+
+// Keeps the k best moves in a bounded min-heap (worst kept move on top).
+template <typename Layout>
+class BasicTopKSink : public BasicMoveSelector<Layout> {
+public:
+    using Move = BasicMove<Layout>;
+
+private:
+    size_t k;
+    std::vector<Move> heap;
+
+    static bool heapOrder(const Move& a, const Move& b) { return isBetter(a, b); }
+
+public:
+    BasicTopKSink(size_t k) : k(k) { heap.reserve(k); }
+
+    void add(const Move& move) override {
+        if (heap.size() < k) {
+            heap.push_back(move);
+            std::push_heap(heap.begin(), heap.end(), heapOrder);
+        } else if (k > 0 && isBetter(move, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), heapOrder);
+            heap.back() = move;
+            std::push_heap(heap.begin(), heap.end(), heapOrder);
+        }
+    }
+
+    bool choose(Move& move) const override {
+        if (heap.empty()) return false;
+        move = *std::min_element(heap.begin(), heap.end(), isBetter<Layout>);
+        return true;
+    }
+
+    // the kept moves, best first
+    std::vector<Move> moves() const {
+        std::vector<Move> ret = heap;
+        std::sort(ret.begin(), ret.end(), isBetter<Layout>);
+        return ret;
+    }
+};
+
+// Considers each move with probability p and keeps the best one considered:
+// the streaming form of picking the best of a random fraction of all moves.
+template <typename Layout>
+class BasicSampledBestSink : public BasicMoveSelector<Layout> {
+public:
+    using Move = BasicMove<Layout>;
+
+private:
+    std::bernoulli_distribution consider;
+    std::default_random_engine rand_engine;
+    bool found = false;
+    Move best;
+
+public:
+    BasicSampledBestSink(double p, unsigned seed) : consider(p), rand_engine(seed) {}
+
+    void add(const Move& move) override {
+        if (!consider(rand_engine)) return;
+        if (!found || isBetter(move, best)) {
+            best = move;
+            found = true;
+        }
+    }
+
+    bool choose(Move& move) const override {
+        if (found) move = best;
+        return found;
+    }
+};
+
+// Keeps a uniform random sample of up to k moves (reservoir sampling), e.g.
+// to pick a move at a given score quantile without sorting all of them.
+template <typename Layout>
+class BasicReservoirSink : public BasicMoveSink<Layout> {
+public:
+    using Move = BasicMove<Layout>;
+
+private:
+    size_t k;
+    size_t seen = 0;
+    std::default_random_engine rand_engine;
+    std::vector<Move> sample;
+
+public:
+    BasicReservoirSink(size_t k, unsigned seed) : k(k), rand_engine(seed) { sample.reserve(k); }
+
+    void add(const Move& move) override {
+        seen++;
+        if (sample.size() < k) {
+            sample.push_back(move);
+            return;
+        }
+        size_t slot = std::uniform_int_distribution<size_t>(0, seen - 1)(rand_engine);
+        if (slot < k) sample[slot] = move;
+    }
+
+    size_t count() const { return seen; }
+
+    // The sampled move at score quantile q (0 = worst, 1 = best). Returns
+    // false if no moves were seen.
+    bool atQuantile(double q, Move& move) const {
+        if (sample.empty()) return false;
+        std::vector<Move> sorted = sample;
+        std::sort(sorted.begin(), sorted.end(), [](const Move& a, const Move& b) { return isBetter(b, a); });
+        size_t idx = std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()));
+        move = sorted[idx];
+        return true;
+    }
+};
+
+// What MoveGenerator instantiations share, so that an algorithm can be named
+// without picking a layout.
+//
+// Both algorithms generate the same moves. TRIE is the default because it is
+// the faster of the two here: on the bench corpus the GADDAG walk enters as
+// many nodes as the trie one, in a node array six times the size, and runs
+// 10-25% slower. GADDAG is kept as a cross-check on TRIE.
+struct MoveGeneratorBase {
+    enum Algorithm { TRIE = 0, GADDAG };
+};
+
+// Generates every legal move for a rack on a board, scored as it goes: each
+// recursion step carries the running main-word points, word multiplier and
+// cross-word points, so moves come out complete and are never validated or
+// scored again.
+//
+// Both algorithms work on one line of the board at a time: pos is the
+// position along the line (x for ACROSS, y for DOWN), and letters/placed/
+// blank hold the word being built, indexed by pos. The line code is a
+// template on the direction, so each direction is compiled separately and
+// never tests which way the line runs. It is a template on the layout too,
+// so the size of a line is a constant everywhere.
+template <typename Layout>
+class BasicMoveGenerator : public MoveGeneratorBase {
+public:
+    static constexpr int SIZE = Layout::SIZE;
+
+    using Board = BasicBoard<Layout>;
+    using Move = BasicMove<Layout>;
+    using MoveSink = BasicMoveSink<Layout>;
+    using MoveBuffer = BasicMoveBuffer<Layout>;
+
+private:
+    const Trie& words;
+    const Trie* gaddag;
+    const LeaveTable* leaves;
+    Board& board;
+    Rack rack;
+    Algorithm algorithm;
+    MoveSink* sink = nullptr;
+
+    // bit pos of anchors[dir][line] for an anchor at pos along the line
+    typename Board::Line anchors[2][SIZE];
+    char letters[SIZE];
+    bool placed[SIZE];
+    bool blank[SIZE];
+
+    static int tilePoints(char letter) { return Layout::Tiles::POINTS[letter - 'A']; }
+
+    template <Direction DIR>
+    Cell* lineCell(int line, int pos) {
+        return DIR == Direction::ACROSS ? board.getCell(pos, line) : board.getCell(line, pos);
+    }
+
+    template <Direction DIR>
+    bool lineEmpty(int line, int pos) { return ((board.occupancy(line, DIR) >> pos) & 1) == 0; }
+
+    template <Direction DIR>
+    bool lineAnchor(int line, int pos) { return (anchors[DIR][line] >> pos) & 1; }
+
+    template <Direction DIR>
+    void addMove(int line, int start, int end, const WordScore& score) {
+        Move move;
+        move.length = end - start + 1;
+        move.dir = DIR;
+        move.x = DIR == Direction::ACROSS ? start : line;
+        move.y = DIR == Direction::ACROSS ? line : start;
+        move.placed = move.blanks = 0;
+        for (int i = 0; i < move.length; i++) {
+            move.letters[i] = letters[start + i];
+            if (placed[start + i]) move.placed |= 1u << i;
+            if (blank[start + i]) move.blanks |= 1u << i;
+        }
+        move.score = score.total();
+        move.equity = move.score + (leaves != nullptr ? leaves->value(rack) : 0.0f);
+        STAT_COUNT(MOVES_EMITTED);
+        sink->add(move);
+    }
+
+    // Calls visit(tile) with each rack tile that can be played as letter ch:
+    // the letter itself and a blank, taken off the rack during the call.
+    // Both are tried so every blank assignment is generated.
+    template <typename Visit>
+    void forEachTile(char ch, Visit visit) {
+        if (rack.has(ch)) {
+            rack.take(ch);
+            visit(ch);
+            rack.add(ch);
+        }
+        if (rack.hasBlank()) {
+            rack.take(Rack::BLANK);
+            visit(Rack::BLANK);
+            rack.add(Rack::BLANK);
+        }
+    }
+
+    // Calls visit(child, score) for each way of covering the cell at pos
+    // from node: the tile already there, or a rack tile that passes the
+    // cross-check (taken off the rack for the duration of the call).
+    template <Direction DIR, typename Visit>
+    void cover(int line, int pos, const TrieNode* node, const WordScore& score, Visit visit) {
+        Cell* cell = lineCell<DIR>(line, pos);
+        if (!cell->isEmpty()) {
+            char ch = cell->getTile().getLetter();
+            const TrieNode* child = node->childAt(ch);
+            if (child == nullptr) return;
+            letters[pos] = ch;
+            placed[pos] = blank[pos] = false;
+            WordScore next = score;
+            next.cover(*cell);
+            visit(child, next);
+            return;
+        }
+        uint32_t mask = node->childMask() & cell->getValidCrosses(crossOf(DIR));
+        if (!rack.hasBlank()) mask &= rack.letterMask();
+        while (mask != 0) {
+            char ch = 'A' + __builtin_ctz(mask);
+            mask &= mask - 1;
+            forEachTile(ch, [&](char tile) {
+                letters[pos] = ch;
+                placed[pos] = true;
+                blank[pos] = tile == Rack::BLANK;
+                WordScore next = score;
+                next.place(*cell, blank[pos] ? 0 : tilePoints(ch), crossOf(DIR));
+                visit(node->childAt(ch), next);
+            });
+        }
+    }
+
+    template <Direction DIR>
+    void extendRight(int line, int pos, int anchor, int start, const TrieNode* node, const WordScore& score) {
+        STAT_COUNT(NODES_VISITED);
+        if (pos >= SIZE || lineEmpty<DIR>(line, pos)) {
+            if (node->isTerminal() && pos != anchor) addMove<DIR>(line, start, pos - 1, score);
+            if (pos >= SIZE) return;
+        }
+        cover<DIR>(line, pos, node, score, [&](const TrieNode* child, const WordScore& next) {
+            extendRight<DIR>(line, pos + 1, anchor, start, child, next);
+        });
+    }
+
+    // Builds left parts of up to limit tiles on the empty, non-anchor cells
+    // before the anchor. Their positions are only known once the left part
+    // is complete, so that is when they are laid down and scored.
+    template <Direction DIR>
+    void leftPart(int line, int anchor, int length, const TrieNode* node, int limit, char* left, bool* left_blank) {
+        STAT_COUNT(NODES_VISITED);
+        WordScore score;
+        int start = anchor - length;
+        for (int i = 0; i < length; i++) {
+            letters[start + i] = left[i];
+            placed[start + i] = true;
+            blank[start + i] = left_blank[i];
+            score.place(*lineCell<DIR>(line, start + i), left_blank[i] ? 0 : tilePoints(left[i]), crossOf(DIR));
+        }
+        extendRight<DIR>(line, anchor, anchor, start, node, score);
+        if (limit > 0) {
+            uint32_t mask = node->childMask();
+            if (!rack.hasBlank()) mask &= rack.letterMask();
+            while (mask != 0) {
+                char ch = 'A' + __builtin_ctz(mask);
+                mask &= mask - 1;
+                forEachTile(ch, [&](char tile) {
+                    left[length] = ch;
+                    left_blank[length] = tile == Rack::BLANK;
+                    leftPart<DIR>(line, anchor, length + 1, node->childAt(ch), limit - 1, left, left_blank);
+                });
+            }
+        }
+    }
+
+    template <Direction DIR>
+    void genWords(int line, int anchor, int limit) {
+        const TrieNode* node = words.getRoot();
+        if (anchor > 0 && !lineEmpty<DIR>(line, anchor - 1)) {
+            int start = anchor;
+            while (start > 0 && !lineEmpty<DIR>(line, start - 1)) start--;
+            WordScore score;
+            for (int pos = start; pos < anchor && node != nullptr; pos++) {
+                Cell* cell = lineCell<DIR>(line, pos);
+                letters[pos] = cell->getTile().getLetter();
+                placed[pos] = blank[pos] = false;
+                score.cover(*cell);
+                node = node->childAt(letters[pos]);
+            }
+            if (node != nullptr) extendRight<DIR>(line, anchor, anchor, start, node, score);
+        } else {
+            char left[SIZE];
+            bool left_blank[SIZE];
+            leftPart<DIR>(line, anchor, 0, node, limit, left, left_blank);
+        }
+    }
+
+    // Grows the word leftwards from the anchor. A move is only generated
+    // from the leftmost anchor it covers, so empty anchors stop the walk.
+    template <Direction DIR>
+    void gaddagLeft(int line, int pos, int anchor, bool right_open, const TrieNode* node, const WordScore& score) {
+        STAT_COUNT(NODES_VISITED);
+        if (pos != anchor && lineAnchor<DIR>(line, pos)) return;
+        bool left_open = pos == 0 || lineEmpty<DIR>(line, pos - 1);
+        Cell* cell = lineCell<DIR>(line, pos);
+        if (!cell->isEmpty()) {
+            char ch = cell->getTile().getLetter();
+            const TrieNode* child = node->childAt(ch);
+            if (child == nullptr) return;
+            letters[pos] = ch;
+            placed[pos] = blank[pos] = false;
+            WordScore next = score;
+            next.cover(*cell);
+            gaddagLeftStep<DIR>(line, pos, anchor, right_open, left_open, child, next);
+            return;
+        }
+        uint32_t mask = node->childMask() & cell->getValidCrosses(crossOf(DIR));
+        if (!rack.hasBlank()) mask &= rack.letterMask();
+        while (mask != 0) {
+            char ch = 'A' + __builtin_ctz(mask);
+            mask &= mask - 1;
+            const TrieNode* child = node->childAt(ch);
+            forEachTile(ch, [&](char tile) {
+                letters[pos] = ch;
+                placed[pos] = true;
+                blank[pos] = tile == Rack::BLANK;
+                WordScore next = score;
+                next.place(*cell, blank[pos] ? 0 : tilePoints(ch), crossOf(DIR));
+                gaddagLeftStep<DIR>(line, pos, anchor, right_open, left_open, child, next);
+            });
+        }
+    }
+
+    // After the cell at pos is covered: the move ending there if both ends
+    // are open, the next cell to the left, and the turn right at the
+    // separator if the left end is open. right_open is fixed for the anchor, so it is
+    // worked out once in generateLine rather than at every step.
+    template <Direction DIR>
+    void gaddagLeftStep(int line, int pos, int anchor, bool right_open, bool left_open, const TrieNode* child,
+                        const WordScore& next) {
+        if (left_open && right_open && child->isTerminal()) addMove<DIR>(line, pos, anchor, next);
+        if (pos > 0) gaddagLeft<DIR>(line, pos - 1, anchor, right_open, child, next);
+        if (left_open && anchor < SIZE - 1) {
+            const TrieNode* separator = child->childAt(TrieNode::SEPARATOR);
+            if (separator != nullptr) gaddagRight<DIR>(line, anchor + 1, pos, separator, next);
+        }
+    }
+
+    template <Direction DIR>
+    void gaddagRight(int line, int pos, int start, const TrieNode* node, const WordScore& score) {
+        STAT_COUNT(NODES_VISITED);
+        cover<DIR>(line, pos, node, score, [&](const TrieNode* child, const WordScore& next) {
+            bool right_open = pos == SIZE - 1 || lineEmpty<DIR>(line, pos + 1);
+            if (child->isTerminal() && right_open) addMove<DIR>(line, start, pos, next);
+            if (pos < SIZE - 1) gaddagRight<DIR>(line, pos + 1, start, child, next);
+        });
+    }
+
+    template <Direction DIR>
+    void generateLine(int line) {
+        if (algorithm == Algorithm::GADDAG) {
+            for (int pos = 0; pos < SIZE; pos++) {
+                if (!lineAnchor<DIR>(line, pos)) continue;
+                STAT_COUNT(ANCHORS);
+                bool right_open = pos == SIZE - 1 || lineEmpty<DIR>(line, pos + 1);
+                gaddagLeft<DIR>(line, pos, pos, right_open, gaddag->getRoot(), WordScore());
+            }
+        } else {
+            int last_anchor = -1;
+            for (int pos = 0; pos < SIZE; pos++) {
+                if (lineAnchor<DIR>(line, pos)) {
+                    STAT_COUNT(ANCHORS);
+                    genWords<DIR>(line, pos, pos - last_anchor - 1);
+                    last_anchor = pos;
+                }
+            }
+        }
+    }
+
+    // Task task of generate: rows ACROSS, then columns DOWN. Each direction
+    // has its own instantiation of the line code above.
+    void generateTask(int task) {
+        if (task < SIZE) generateLine<Direction::ACROSS>(task);
+        else generateLine<Direction::DOWN>(task - SIZE);
+    }
+
+public:
+    static constexpr int LINES = 2 * SIZE;
+
+    // lexicon must have its GADDAG loaded for Algorithm::GADDAG.
+    BasicMoveGenerator(const Lexicon& lexicon, Board& board, Rack rack, Algorithm algorithm)
+        : words(lexicon.words()), gaddag(lexicon.gaddagWords()), leaves(lexicon.leaves()), board(board), rack(rack),
+          algorithm(algorithm) {
+        assert(algorithm != Algorithm::GADDAG || gaddag != nullptr);
+        for (int line = 0; line < SIZE; line++) {
+            anchors[Direction::ACROSS][line] = board.anchors(line, Direction::ACROSS);
+            anchors[Direction::DOWN][line] = board.anchors(line, Direction::DOWN);
+        }
+    }
+
+    // Moves come out line by line: the rows ACROSS, then the columns DOWN.
+    // Lines only read the board, so with a pool each one runs as its own
+    // task on a copy of the generator (and so of the rack), into its own
+    // buffer. The buffers are passed to out in line order, so out sees
+    // exactly the same moves in the same order as without a pool.
+    void generate(MoveSink& out, ThreadPool* pool = nullptr) {
+        if (pool == nullptr || pool->size() < 2) {
+            sink = &out;
+            for (int task = 0; task < LINES; task++) {
+                generateTask(task);
+            }
+            sink = nullptr;
+            return;
+        }
+
+        MoveBuffer buffers[LINES];
+        pool->parallelFor(LINES, [&](size_t task) {
+            BasicMoveGenerator worker = *this;
+            worker.sink = &buffers[task];
+            worker.generateTask(task);
+        });
+        for (const MoveBuffer& buffer : buffers) {
+            for (const Move& move : buffer.moves) out.add(move);
+        }
+    }
+};
+
+using MoveSink = BasicMoveSink<StandardLayout>;
+using MoveBuffer = BasicMoveBuffer<StandardLayout>;
+using MoveSelector = BasicMoveSelector<StandardLayout>;
+using TopKSink = BasicTopKSink<StandardLayout>;
+using SampledBestSink = BasicSampledBestSink<StandardLayout>;
+using ReservoirSink = BasicReservoirSink<StandardLayout>;
+using MoveGenerator = BasicMoveGenerator<StandardLayout>;
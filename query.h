@@ -0,0 +1,213 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "board.h"
+#include "thread_pool.h"
+
+// A word-finder lookup. Words must fit pattern: a letter matches itself, '?'
+// any one letter and '*' any run of letters, so "*" is every word and "C?T"
+// the three-letter words from C to T. With a rack, every letter matched by
+// a '?' or '*' is a tile taken from it, '?' in the rack being a blank, while
+// the pattern's own letters are already on the board. Without one they
+// match any letter.
+struct WordQuery {
+    std::string rack;
+    std::string pattern = "*";
+    bool all_tiles = false;  // only words that use the whole rack
+};
+
+// Answers WordQuerys over a DAWG lexicon by walking it with the rack: a
+// wildcard only follows the children the rack has letters for (all of them
+// if it has a blank), and a letter is taken from a blank only when the rack
+// has none of its own, so each word is found once.
+//
+// The index built up front holds, for every node, the fewest and most
+// letters from it to the end of a word. A subtree is skipped as soon as no
+// word in it can have the number of letters the rest of the pattern and
+// the rack left allow.
+class WordFinder {
+private:
+    static constexpr uint8_t NONE = 0xFF;
+
+    const Trie& lexicon;
+    std::vector<uint8_t> min_rest;
+    std::vector<uint8_t> max_rest;
+
+    // One query's walk: the word so far, the tiles left, and for each
+    // position of the pattern how many letters and '?'s follow it and
+    // whether a '*' does.
+    struct Search {
+        const WordQuery& query;
+        bool limited;
+        Rack rack;
+        std::string word;
+        std::vector<int> fixed_after;
+        std::vector<int> any_after;
+        std::vector<bool> star_after;
+        std::vector<std::string> found;
+
+        Search(const WordQuery& query) : query(query), limited(!query.rack.empty()) {
+            for (char ch : query.rack) rack.add(ch == '?' ? Rack::BLANK : toupper(ch));
+            size_t length = query.pattern.length();
+            fixed_after.assign(length + 1, 0);
+            any_after.assign(length + 1, 0);
+            star_after.assign(length + 1, false);
+            for (size_t i = length; i-- > 0;) {
+                char ch = query.pattern[i];
+                fixed_after[i] = fixed_after[i + 1] + (ch != '?' && ch != '*');
+                any_after[i] = any_after[i + 1] + (ch == '?');
+                star_after[i] = star_after[i + 1] || ch == '*';
+            }
+        }
+    };
+
+    size_t indexOf(const TrieNode* node) const { return node - lexicon.getRoot(); }
+
+    void buildIndex(const TrieNode* node) {
+        size_t idx = indexOf(node);
+        if (min_rest[idx] != NONE) return;
+        uint8_t shortest = node->isTerminal() ? 0 : NONE - 1;
+        uint8_t longest = 0;
+        uint32_t letters = node->childMask();
+        while (letters != 0) {
+            const TrieNode* child = node->childAt('A' + __builtin_ctz(letters));
+            letters &= letters - 1;
+            buildIndex(child);
+            shortest = std::min<int>(shortest, min_rest[indexOf(child)] + 1);
+            longest = std::max<int>(longest, max_rest[indexOf(child)] + 1);
+        }
+        min_rest[idx] = shortest;
+        max_rest[idx] = longest;
+    }
+
+    // Whether a word below node could match the pattern from pos on.
+    bool feasible(const Search& search, const TrieNode* node, size_t pos) const {
+        int fixed = search.fixed_after[pos];
+        int any = search.any_after[pos];
+        bool star = search.star_after[pos];
+        int least = fixed + any;
+        int most = star ? 0xFF : fixed + any;
+        if (search.limited) {
+            int tiles = search.rack.size();
+            if (any > tiles) return false;
+            if (star) most = fixed + tiles;
+            if (search.query.all_tiles) {
+                if (!star && any != tiles) return false;
+                least = fixed + tiles;
+            }
+        }
+        return min_rest[indexOf(node)] <= most && max_rest[indexOf(node)] >= least;
+    }
+
+    // Calls visit(child) for each letter a wildcard can be at node, with the
+    // letter added to the word (lowercase from a blank) and its tile taken.
+    template <typename Visit>
+    void forEachLetter(Search& search, const TrieNode* node, Visit visit) const {
+        uint32_t mask = node->childMask();
+        if (search.limited && !search.rack.hasBlank()) mask &= search.rack.letterMask();
+        while (mask != 0) {
+            char ch = 'A' + __builtin_ctz(mask);
+            mask &= mask - 1;
+            char tile = !search.limited ? '\0' : search.rack.has(ch) ? ch : Rack::BLANK;
+            if (tile != '\0') search.rack.take(tile);
+            search.word += tile == Rack::BLANK ? tolower(ch) : ch;
+            visit(node->childAt(ch));
+            search.word.pop_back();
+            if (tile != '\0') search.rack.add(tile);
+        }
+    }
+
+    void walk(Search& search, const TrieNode* node, size_t pos) const {
+        if (!feasible(search, node, pos)) return;
+        const std::string& pattern = search.query.pattern;
+        if (pos == pattern.length()) {
+            if (node->isTerminal() && (!search.query.all_tiles || search.rack.empty())) {
+                search.found.push_back(search.word);
+            }
+            return;
+        }
+        char ch = pattern[pos];
+        if (ch == '*') {
+            walk(search, node, pos + 1);
+            forEachLetter(search, node, [&](const TrieNode* child) { walk(search, child, pos); });
+        } else if (ch == '?') {
+            forEachLetter(search, node, [&](const TrieNode* child) { walk(search, child, pos + 1); });
+        } else {
+            const TrieNode* child = node->childAt(toupper(ch));
+            if (child == nullptr) return;
+            search.word += toupper(ch);
+            walk(search, child, pos + 1);
+            search.word.pop_back();
+        }
+    }
+
+    static bool validPattern(const std::string& pattern) {
+        return std::all_of(pattern.begin(), pattern.end(), [](char ch) {
+            return ch == '?' || ch == '*' || isalpha(ch);
+        });
+    }
+
+    static bool validRack(const std::string& rack) {
+        return std::all_of(rack.begin(), rack.end(), [](char ch) { return ch == '?' || isalpha(ch); });
+    }
+
+public:
+    // lexicon must be a DAWG and outlive the finder.
+    WordFinder(const Trie& lexicon)
+        : lexicon(lexicon), min_rest(lexicon.arraySize(), NONE), max_rest(lexicon.arraySize(), 0) {
+        buildIndex(lexicon.getRoot());
+    }
+
+    // The matching words, longest first and then in alphabetical order, with
+    // the letters made from blanks lowercase. An invalid rack or pattern
+    // matches nothing.
+    std::vector<std::string> find(const WordQuery& query) const {
+        if (!validRack(query.rack) || !validPattern(query.pattern)) return {};
+        Search state(query);
+        walk(state, lexicon.getRoot(), 0);
+        std::vector<std::string>& found = state.found;
+        // The walk takes letters in order, so it finds words alphabetically
+        // unless a '*' has more of the pattern after it, and it only finds a
+        // word more than one way when there are several '*'s.
+        const std::string& pattern = query.pattern;
+        size_t star = pattern.find('*');
+        if (star != std::string::npos && star + 1 < pattern.length()) {
+            std::sort(found.begin(), found.end(), [](const std::string& a, const std::string& b) {
+                for (size_t i = 0; i < a.length() && i < b.length(); i++) {
+                    if (toupper(a[i]) != toupper(b[i])) return toupper(a[i]) < toupper(b[i]);
+                }
+                return a.length() != b.length() ? a.length() < b.length() : a < b;
+            });
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+        }
+        // longest first, keeping each length's words in order
+        std::vector<std::vector<std::string>> by_length;
+        for (std::string& word : found) {
+            if (word.length() >= by_length.size()) by_length.resize(word.length() + 1);
+            by_length[word.length()].push_back(std::move(word));
+        }
+        std::vector<std::string> ret;
+        ret.reserve(found.size());
+        for (size_t length = by_length.size(); length-- > 0;) {
+            for (std::string& word : by_length[length]) ret.push_back(std::move(word));
+        }
+        return ret;
+    }
+
+    // Answers each query, as tasks on pool if there is one.
+    std::vector<std::vector<std::string>> findAll(const std::vector<WordQuery>& queries,
+                                                  ThreadPool* pool = nullptr) const {
+        std::vector<std::vector<std::string>> ret(queries.size());
+        auto answer = [&](size_t i) { ret[i] = find(queries[i]); };
+        if (pool != nullptr) {
+            pool->parallelFor(queries.size(), answer);
+        } else {
+            for (size_t i = 0; i < queries.size(); i++) answer(i);
+        }
+        return ret;
+    }
+};
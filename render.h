@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <unistd.h>
+
+// A fixed-size grid of styled characters drawn to the terminal. Each frame
+// is drawn into a back buffer, and present() compares it with the frame on
+// screen and sends only the characters that changed, moving the cursor to
+// them with escape codes, in a single write().
+class Screen {
+public:
+    enum Style : uint8_t { PLAIN = 0, TILE, DW, TW, DL, TL };
+
+private:
+    struct Glyph {
+        char ch = ' ';
+        Style style = PLAIN;
+
+        bool operator==(const Glyph& other) const { return ch == other.ch && style == other.style; }
+        bool operator!=(const Glyph& other) const { return !(*this == other); }
+    };
+
+    // Unchanged characters between two changes are sent again rather than
+    // jumping over them when the gap is shorter than a cursor move.
+    static constexpr int MAX_GAP = 6;
+
+    int rows = 0;
+    int cols = 0;
+    std::vector<Glyph> back;
+    std::vector<Glyph> front;
+    bool stale = true;
+
+    static const char* sgr(Style style) {
+        switch (style) {
+            case TILE: return "\e[1;33m";
+            case DW: return "\e[1;35m";
+            case TW: return "\e[1;31m";
+            case DL: return "\e[1;36m";
+            case TL: return "\e[1;34m";
+            default: return "\e[0m";
+        }
+    }
+
+    static void moveTo(std::string& out, int row, int col) {
+        out += "\e[" + std::to_string(row + 1) + ";" + std::to_string(col + 1) + "H";
+    }
+
+public:
+    // Starts a new frame of rows x cols blanks. A frame of a different size
+    // from the last one is drawn in full.
+    void clear(int rows, int cols) {
+        if (rows != this->rows || cols != this->cols) {
+            this->rows = rows;
+            this->cols = cols;
+            stale = true;
+        }
+        back.assign(rows * cols, Glyph());
+    }
+
+    // Writes text from (row, col), clipped to the frame.
+    void text(int row, int col, const std::string& text, Style style = PLAIN) {
+        if (row < 0 || row >= rows) return;
+        for (size_t i = 0; i < text.length() && col + static_cast<int>(i) < cols; i++) {
+            if (col + static_cast<int>(i) < 0) continue;
+            back[row * cols + col + i] = { text[i], style };
+        }
+    }
+
+    // Sends the changes since the last frame, then leaves the cursor on the
+    // line below the frame with the rest of the screen cleared, ready for
+    // prompts. Anything buffered in std::cout goes out first.
+    void present() {
+        std::string out;
+        if (stale) {
+            out += "\e[H\e[2J";
+            front.assign(rows * cols, Glyph());
+            // force every non-blank character out
+            for (Glyph& glyph : front) glyph.ch = '\0';
+        }
+        Style current = PLAIN;
+        out += sgr(current);
+        for (int row = 0; row < rows; row++) {
+            const Glyph* now = &back[row * cols];
+            const Glyph* was = &front[row * cols];
+            int cursor = -1;
+            for (int col = 0; col < cols; col++) {
+                if (now[col] == was[col]) continue;
+                if (stale && now[col] == Glyph()) continue;
+                if (cursor < 0 || col - cursor > MAX_GAP) {
+                    moveTo(out, row, col);
+                    cursor = col;
+                }
+                for (; cursor <= col; cursor++) {
+                    if (now[cursor].style != current) {
+                        current = now[cursor].style;
+                        out += sgr(current);
+                    }
+                    out += now[cursor].ch;
+                }
+            }
+        }
+        if (current != PLAIN) out += sgr(PLAIN);
+        moveTo(out, rows, 0);
+        out += "\e[J";
+        front = back;
+        stale = false;
+
+        std::cout.flush();
+        for (size_t sent = 0; sent < out.length();) {
+            ssize_t n = ::write(STDOUT_FILENO, out.data() + sent, out.length() - sent);
+            if (n <= 0) break;
+            sent += n;
+        }
+    }
+};
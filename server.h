@@ -0,0 +1,367 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "movegen.h"
+#include "thread_pool.h"
+
+// One client's engine state and the line protocol it speaks. Each request
+// is a line of words and gets exactly one line back, starting "ok" or "err":
+//
+//   position [ROWS]        the board, as loadRows rows joined with '/';
+//                          an empty board without ROWS
+//   rack [TILES]           letters, '?' for a blank; no tiles without TILES
+//   gen [N]                the N best moves (default 10): "ok COUNT" then
+//                          "WORD X Y A|D SCORE" for each, separated by ';'
+//   score WORD X Y A|D     "ok SCORE" if the rack can play it there
+//   check WORD...          "ok" then 1 or 0 for each word in the lexicon
+//   quit                   "ok", then the session ends
+//
+// Letters in a move's WORD that come from a blank are lowercase.
+class Session {
+public:
+    static constexpr int DEFAULT_MOVES = 10;
+    static constexpr int MAX_MOVES = 1000;
+
+private:
+    const Lexicon& lexicon;
+    MoveGenerator::Algorithm algorithm;
+    ThreadPool* pool;
+    Board board;
+    Rack rack;
+    bool done = false;
+
+    static std::string error(const std::string& message) { return "err " + message; }
+
+    static bool parseDirection(const std::string& text, Direction& dir) {
+        if (text == "A" || text == "a") dir = Direction::ACROSS;
+        else if (text == "D" || text == "d") dir = Direction::DOWN;
+        else return false;
+        return true;
+    }
+
+    static std::string upper(std::string word) {
+        for (char& ch : word) ch = toupper(static_cast<unsigned char>(ch));
+        return word;
+    }
+
+    static bool isWord(const std::string& word) {
+        return !word.empty() && std::all_of(word.begin(), word.end(), [](unsigned char ch) { return isalpha(ch); });
+    }
+
+    static std::string formatMove(const Move& move) {
+        std::string word = move.word();
+        for (int i = 0; i < move.length; i++) {
+            if (move.isBlank(i)) word[i] = tolower(word[i]);
+        }
+        return word + " " + std::to_string(move.x) + " " + std::to_string(move.y) + " " +
+               (move.dir == Direction::ACROSS ? "A" : "D") + " " + std::to_string(move.score);
+    }
+
+    std::string setPosition(std::istream& args) {
+        std::string text;
+        if (!(args >> text)) {
+            board = Board(lexicon.words());
+            return "ok";
+        }
+        std::vector<std::string> rows;
+        std::stringstream buf(text);
+        for (std::string row; getline(buf, row, '/');) rows.push_back(row);
+        Board loaded(lexicon.words());
+        if (!loaded.loadRows(rows)) return error("bad position");
+        board = loaded;
+        return "ok";
+    }
+
+    std::string setRack(std::istream& args) {
+        std::string tiles;
+        args >> tiles;
+        if (tiles.length() > Rack::SIZE) return error("too many tiles");
+        Rack loaded;
+        for (unsigned char ch : tiles) {
+            if (ch == '?') loaded.add(Rack::BLANK);
+            else if (isalpha(ch)) loaded.add(toupper(ch));
+            else return error("bad rack");
+        }
+        rack = loaded;
+        return "ok";
+    }
+
+    std::string generate(std::istream& args) {
+        int count = DEFAULT_MOVES;
+        std::string text;
+        if (args >> text) {
+            char* end;
+            long n = strtol(text.c_str(), &end, 10);
+            if (*end != '\0' || n < 1 || n > MAX_MOVES) return error("bad move count");
+            count = n;
+        }
+        TopKSink best(count);
+        MoveGenerator(lexicon, board, rack, algorithm).generate(best, pool);
+        std::vector<Move> moves = best.moves();
+        std::string ret = "ok " + std::to_string(moves.size());
+        for (size_t i = 0; i < moves.size(); i++) ret += (i == 0 ? " " : ";") + formatMove(moves[i]);
+        return ret;
+    }
+
+    std::string score(std::istream& args) {
+        std::string word, sdir;
+        int x, y;
+        Direction dir;
+        if (!(args >> word >> x >> y >> sdir) || !parseDirection(sdir, dir) || !isWord(word)) {
+            return error("usage: score WORD X Y A|D");
+        }
+        if (x < 0 || x >= Board::SIZE || y < 0 || y >= Board::SIZE) return error("off the board");
+        Rack tiles = rack;
+        int points = board.placeWord(upper(word), x, y, dir, tiles, true);
+        if (points < 0) return error("illegal move");
+        return "ok " + std::to_string(points);
+    }
+
+    std::string check(std::istream& args) {
+        std::string ret = "ok";
+        for (std::string word; args >> word;) ret += isWord(word) && lexicon.words().isLegal(upper(word)) ? " 1" : " 0";
+        return ret;
+    }
+
+public:
+    // Moves are generated on pool, if there is one, a line per task.
+    Session(const Lexicon& lexicon, MoveGenerator::Algorithm algorithm, ThreadPool* pool = nullptr)
+        : lexicon(lexicon), algorithm(algorithm), pool(pool), board(lexicon.words()) {}
+
+    // The response to one request line, without its newline.
+    std::string handle(const std::string& line) {
+        std::stringstream args(line);
+        std::string command;
+        if (!(args >> command)) return error("empty request");
+        if (command == "position") return setPosition(args);
+        if (command == "rack") return setRack(args);
+        if (command == "gen") return generate(args);
+        if (command == "score") return score(args);
+        if (command == "check") return check(args);
+        if (command == "quit") {
+            done = true;
+            return "ok";
+        }
+        return error("unknown command " + command);
+    }
+
+    // whether the client has asked to end the session
+    bool finished() const { return done; }
+};
+
+// Serves Sessions over standard input and output, or to any number of
+// clients on a Unix domain socket, every session sharing one lexicon.
+//
+// On a socket, one thread polls the listening socket and every idle client.
+// Complete request lines are handed to the pool as a task per client, which
+// answers them in order and writes the responses, so many sessions are
+// served at once while each sees its requests answered one at a time. A
+// client is not polled while its task runs; a byte on a pipe wakes the
+// poller when one finishes.
+class Server {
+public:
+    // the longest request line a socket client may send; one that sends
+    // more without a newline is told so and dropped
+    static constexpr size_t MAX_LINE = 4096;
+
+private:
+    struct Client {
+        int fd;
+        Session session;
+        std::string input;
+        std::atomic<bool> busy{false};
+        // it will send nothing more: closed once its complete lines are answered
+        bool hung_up = false;
+        bool closed = false;
+
+        Client(int fd, const Lexicon& lexicon, MoveGenerator::Algorithm algorithm)
+            : fd(fd), session(lexicon, algorithm) {}
+    };
+
+    const Lexicon& lexicon;
+    MoveGenerator::Algorithm algorithm;
+    ThreadPool& pool;
+    int wake_pipe[2] = { -1, -1 };
+    std::map<int, std::unique_ptr<Client>> clients;
+
+    static bool sendAll(int fd, const std::string& out) {
+        for (size_t sent = 0; sent < out.length();) {
+            ssize_t n = ::send(fd, out.data() + sent, out.length() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    // Runs on the pool: answers the requests in lines and sends the
+    // responses back in one write.
+    void answer(Client& client, std::string lines) {
+        std::string out;
+        std::stringstream requests(lines);
+        for (std::string line; !client.session.finished() && getline(requests, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            out += client.session.handle(line) + "\n";
+        }
+        if (!sendAll(client.fd, out) || client.session.finished()) client.closed = true;
+        client.busy = false;
+        char byte = 0;
+        while (::write(wake_pipe[1], &byte, 1) < 0 && errno == EINTR) {}
+    }
+
+    // Hands the client's complete lines to the pool, if it has any and is
+    // not already being answered.
+    void dispatch(Client& client) {
+        size_t end = client.input.rfind('\n');
+        if (client.busy || end == std::string::npos) return;
+        std::string lines = client.input.substr(0, end + 1);
+        client.input.erase(0, end + 1);
+        client.busy = true;
+        pool.submit([this, &client, lines] { answer(client, lines); });
+    }
+
+    // whether every line of input, finished or not, is at most MAX_LINE long
+    static bool linesFit(const std::string& input) {
+        size_t start = 0;
+        for (size_t end; (end = input.find('\n', start)) != std::string::npos; start = end + 1) {
+            if (end - start > MAX_LINE) return false;
+        }
+        return input.length() - start <= MAX_LINE;
+    }
+
+    // Reads what the client has sent, noting when it has hung up. A line
+    // over MAX_LINE closes the client at once.
+    void receive(Client& client) {
+        char buf[4096];
+        ssize_t n = ::read(client.fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) return;
+        if (n <= 0) {
+            client.hung_up = true;
+            return;
+        }
+        client.input.append(buf, n);
+        if (!linesFit(client.input)) {
+            sendAll(client.fd, "err line too long\n");
+            client.closed = true;
+        }
+    }
+
+    void accept(int listener) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) return;
+        clients[fd] = std::make_unique<Client>(fd, lexicon, algorithm);
+    }
+
+    int listen(const std::string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.length() >= sizeof(addr.sun_path)) {
+            std::cerr << path << ": socket path too long" << std::endl;
+            return -1;
+        }
+        strcpy(addr.sun_path, path.c_str());
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            std::cerr << "socket: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        // a socket file left by an earlier server would fail the bind
+        ::unlink(path.c_str());
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+            std::cerr << path << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+public:
+    Server(const Lexicon& lexicon, MoveGenerator::Algorithm algorithm, ThreadPool& pool)
+        : lexicon(lexicon), algorithm(algorithm), pool(pool) {}
+
+    // Answers requests from standard input until it ends or the client
+    // quits, generating moves on the pool.
+    void serveStdio() {
+        Session session(lexicon, algorithm, &pool);
+        for (std::string line; !session.finished() && getline(std::cin, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::cout << session.handle(line) << "\n" << std::flush;
+        }
+    }
+
+    // Serves clients on a socket at path until it fails. Returns false if
+    // the socket could not be set up.
+    bool serveSocket(const std::string& path) {
+        int listener = listen(path);
+        if (listener < 0) return false;
+        if (::pipe(wake_pipe) < 0) {
+            std::cerr << "pipe: " << strerror(errno) << std::endl;
+            ::close(listener);
+            return false;
+        }
+
+        std::vector<pollfd> fds;
+        while (true) {
+            fds.clear();
+            fds.push_back({ listener, POLLIN, 0 });
+            fds.push_back({ wake_pipe[0], POLLIN, 0 });
+            for (auto& entry : clients) {
+                const Client& client = *entry.second;
+                if (!client.busy && !client.hung_up && !client.closed) fds.push_back({ entry.first, POLLIN, 0 });
+            }
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "poll: " << strerror(errno) << std::endl;
+                break;
+            }
+
+            if (fds[1].revents != 0) {
+                char buf[256];
+                ::read(wake_pipe[0], buf, sizeof(buf));
+            }
+            for (size_t i = 2; i < fds.size(); i++) {
+                if (fds[i].revents == 0) continue;
+                receive(*clients[fds[i].fd]);
+            }
+            // a client that has hung up still gets answers to the lines it sent
+            for (auto it = clients.begin(); it != clients.end();) {
+                Client& client = *it->second;
+                if (!client.busy && !client.closed) dispatch(client);
+                if (!client.busy && (client.closed || client.hung_up)) {
+                    ::close(client.fd);
+                    it = clients.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (fds[0].revents != 0) accept(listener);
+        }
+
+        for (auto& entry : clients) {
+            // let running tasks finish before their clients go away
+            while (entry.second->busy) std::this_thread::yield();
+            ::close(entry.first);
+        }
+        clients.clear();
+        ::close(listener);
+        ::close(wake_pipe[0]);
+        ::close(wake_pipe[1]);
+        ::unlink(path.c_str());
+        return true;
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include "movegen.h"
+#include "thread_pool.h"
+
+// Chooses a move by simulation: each of the top candidates by equity (score
+// plus leave) is played out a few plies against opponent racks sampled from
+// the unseen tiles, both sides then playing their best move by equity, and the
+// candidate with the best average spread over its playouts is chosen. Each
+// side's last move also counts the value of the tiles it kept.
+class Simulator {
+public:
+    struct Settings {
+        int candidates = 10;
+        int plies = 2;            // replies played out after the candidate
+        double seconds = 1.0;     // wall-clock budget per move
+        int max_playouts = 1000;  // per candidate
+    };
+
+private:
+    // playouts each candidate runs between checks of the clock
+    static constexpr int BATCH = 8;
+
+    const Lexicon& lexicon;
+    Board board;
+    Rack rack;
+    std::vector<char> unseen;
+    MoveGenerator::Algorithm algorithm;
+    Settings settings;
+
+    // Our spread over one playout of candidate from position, which is left
+    // as it was. The opponent's rack is the first tiles of a shuffle of the
+    // unseen ones and the rest are the bag.
+    float playout(const Move& candidate, Board& position, std::default_random_engine& rand_engine) {
+        std::vector<char> tiles = unseen;
+        std::shuffle(tiles.begin(), tiles.end(), rand_engine);
+        size_t next = 0;
+        auto draw = [&](Rack& to) {
+            while (to.size() < Rack::SIZE && next < tiles.size()) to.add(tiles[next++]);
+        };
+
+        Rack racks[2] = { rack, Rack() };
+        draw(racks[1]);
+        float spread = position.makeMove(candidate, racks[0]);
+        float leave[2] = { candidate.equity - candidate.score, 0.0f };
+        draw(racks[0]);
+        for (int ply = 1; ply <= settings.plies && !racks[0].empty(); ply++) {
+            int player = ply % 2;
+            TopKSink best(1);
+            MoveGenerator(lexicon, position, racks[player], algorithm).generate(best);
+            Move move;
+            if (!best.choose(move)) continue;
+            int points = position.makeMove(move, racks[player]);
+            spread += player == 0 ? points : -points;
+            leave[player] = move.equity - move.score;
+            draw(racks[player]);
+            if (racks[player].empty()) break;
+        }
+        // the racks are done with, so the tiles can go back on either
+        while (position.undoDepth() > 0) position.unmakeMove(racks[0]);
+        return spread + leave[0] - leave[1];
+    }
+
+public:
+    // unseen holds the tiles rack's owner cannot see: the bag and the
+    // opponent's rack, blanks as Rack::BLANK.
+    Simulator(const Lexicon& lexicon, const Board& board, Rack rack, std::vector<char> unseen,
+              MoveGenerator::Algorithm algorithm, Settings settings)
+        : lexicon(lexicon), board(board), rack(rack), unseen(std::move(unseen)), algorithm(algorithm),
+          settings(settings) {
+        this->settings.plies = std::min(settings.plies, Board::MAX_UNDO - 1);
+    }
+
+    // Sets move to the chosen move. Returns false if there was none.
+    // Candidates run in rounds of up to BATCH playouts, on pool if there is
+    // one, until the budget runs out. Each has its own random engine, so
+    // when the playout cap is reached first the choice depends only on seed.
+    bool choose(Move& move, ThreadPool* pool, unsigned seed) {
+        TopKSink top(settings.candidates);
+        MoveGenerator(lexicon, board, rack, algorithm).generate(top);
+        std::vector<Move> candidates = top.moves();
+        if (candidates.empty()) return false;
+        move = candidates[0];
+        if (candidates.size() == 1) return true;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(settings.seconds);
+        size_t count = candidates.size();
+        std::vector<std::default_random_engine> engines;
+        for (size_t i = 0; i < count; i++) engines.emplace_back(seed + i);
+        // a board per candidate, as they may be played out on different threads
+        std::vector<Board> positions(count, board);
+        std::vector<double> totals(count, 0);
+        std::vector<int> counts(count, 0);
+        int playouts = 0;
+        do {
+            int batch = std::min(BATCH, settings.max_playouts - playouts);
+            auto simulate = [&](size_t i) {
+                for (int j = 0; j < batch && (j == 0 || std::chrono::steady_clock::now() < deadline); j++) {
+                    totals[i] += playout(candidates[i], positions[i], engines[i]);
+                    counts[i]++;
+                }
+            };
+            if (pool != nullptr) {
+                pool->parallelFor(count, simulate);
+            } else {
+                for (size_t i = 0; i < count; i++) simulate(i);
+            }
+            playouts += batch;
+        } while (playouts < settings.max_playouts && std::chrono::steady_clock::now() < deadline);
+
+        size_t best = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (counts[i] > 0 && totals[i] * counts[best] > totals[best] * counts[i]) best = i;
+        }
+        move = candidates[best];
+        return true;
+    }
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "board.h"
+
+// A game position as one fixed-size record: the tiles, both racks and
+// scores, the bag in draw order, and the state of the bag's and the game's
+// random engines. Records are plain data, saved and loaded with memcpy.
+struct Snapshot {
+    static constexpr int MAX_BAG = 100;
+
+    char tiles[Board::SIZE][Board::SIZE];  // as Board::saveTiles
+    Board::Line blanks[Board::SIZE];
+    uint8_t racks[2][27];                  // count of each tile, A-Z then the blank
+    int32_t scores[2];
+    uint64_t bag_engine;
+    uint64_t game_engine;
+    uint8_t to_move;                       // the player whose turn it is
+    uint8_t bag_size;
+    char bag[MAX_BAG];                     // next tile drawn first, Rack::BLANK for a blank
+};
+
+// The cross-checks of a Snapshot's board, as Board::saveCrosses. Optional in
+// a file: they take several times the space of the rest, but loading them
+// saves recomputing every cross-check. Padded so that records stay aligned
+// in a mapped file.
+struct alignas(8) SnapshotCrosses {
+    uint32_t masks[2][Board::SIZE][Board::SIZE];
+    int16_t points[2][Board::SIZE][Board::SIZE];
+};
+
+static_assert(std::is_trivially_copyable<Snapshot>::value, "snapshots are copied as bytes");
+static_assert(std::is_trivially_copyable<SnapshotCrosses>::value, "snapshots are copied as bytes");
+
+// Header of a snapshot file. Records follow it back to back, each a Snapshot
+// then, with CROSSES set, a SnapshotCrosses. The count is not stored, so a
+// file can be written as a stream; it is the rest of the file over
+// record_size. Like compiled lexicons, the layout is native-endian.
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = { 'S', 'C', 'R', 'B', 'S', 'N', 'A', 'P' };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ENDIAN_CHECK = 0x01020304;
+    static constexpr uint32_t CROSSES = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_check;
+    uint32_t flags;
+    uint32_t record_size;
+
+    static SnapshotHeader make(bool crosses) {
+        SnapshotHeader header;
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.endian_check = ENDIAN_CHECK;
+        header.flags = crosses ? CROSSES : 0;
+        header.record_size = sizeof(Snapshot) + (crosses ? sizeof(SnapshotCrosses) : 0);
+        return header;
+    }
+
+    bool valid() const {
+        if (memcmp(magic, MAGIC, sizeof(magic)) != 0 || version != VERSION || endian_check != ENDIAN_CHECK) {
+            return false;
+        }
+        return record_size == make((flags & CROSSES) != 0).record_size;
+    }
+};
+
+// The random engines are multiplicative linear congruential generators,
+// whose whole state is one number, and seeding one with a state it can be
+// in puts it in exactly that state.
+static_assert(std::is_trivially_copyable<std::default_random_engine>::value &&
+                  sizeof(std::default_random_engine) <= sizeof(uint64_t) &&
+                  std::default_random_engine::increment == 0,
+              "snapshots store a random engine as its one-word state");
+
+inline uint64_t engineState(const std::default_random_engine& engine) {
+    uint64_t ret = 0;
+    memcpy(&ret, &engine, sizeof(engine));
+    return ret;
+}
+
+inline void setEngineState(std::default_random_engine& engine, uint64_t state) { engine.seed(state); }
+
+// Writes a header and then records to out, which can be a pipe.
+class SnapshotWriter {
+private:
+    std::ostream& out;
+    bool crosses;
+
+public:
+    // With crosses, every record written must come with its cross-checks.
+    SnapshotWriter(std::ostream& out, bool crosses) : out(out), crosses(crosses) {
+        SnapshotHeader header = SnapshotHeader::make(crosses);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void write(const Snapshot& snapshot, const SnapshotCrosses* cross_checks = nullptr) {
+        out.write(reinterpret_cast<const char*>(&snapshot), sizeof(snapshot));
+        if (crosses) out.write(reinterpret_cast<const char*>(cross_checks), sizeof(*cross_checks));
+    }
+
+    bool good() const { return out.good(); }
+};
+
+// Reads records one at a time from a stream, for files too big to map or
+// coming down a pipe.
+class SnapshotReader {
+private:
+    std::istream& in;
+    SnapshotHeader header;
+    bool valid;
+
+public:
+    SnapshotReader(std::istream& in) : in(in) {
+        valid = in.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.valid();
+    }
+
+    // whether the stream started with a header this build understands
+    bool good() const { return valid; }
+
+    bool hasCrosses() const { return valid && (header.flags & SnapshotHeader::CROSSES) != 0; }
+
+    // Reads the next record into snapshot, and its cross-checks into
+    // cross_checks if the file has them and it is not null. Returns false
+    // at the end of the stream.
+    bool next(Snapshot& snapshot, SnapshotCrosses* cross_checks = nullptr) {
+        if (!valid || !in.read(reinterpret_cast<char*>(&snapshot), sizeof(snapshot))) return false;
+        if (!hasCrosses()) return true;
+        if (cross_checks != nullptr) return static_cast<bool>(in.read(reinterpret_cast<char*>(cross_checks),
+                                                                      sizeof(*cross_checks)));
+        return static_cast<bool>(in.ignore(sizeof(SnapshotCrosses)));
+    }
+};
+
+// A whole snapshot file mapped read-only, its records used in place.
+class SnapshotFile {
+private:
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    SnapshotHeader header;
+    size_t count = 0;
+
+    const char* record(size_t i) const {
+        return static_cast<const char*>(mapping) + sizeof(header) + i * header.record_size;
+    }
+
+public:
+    // Check good() before use: the file may be missing or not a snapshot
+    // file. A partly written last record is left out.
+    SnapshotFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(header) ||
+            pread(fd, &header, sizeof(header), 0) != sizeof(header) || !header.valid()) {
+            std::cerr << filename << ": not a snapshot file for this build" << std::endl;
+            close(fd);
+            return;
+        }
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) return;
+        mapping = addr;
+        mapping_size = st.st_size;
+        count = (mapping_size - sizeof(header)) / header.record_size;
+    }
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    ~SnapshotFile() {
+        if (mapping != nullptr) munmap(mapping, mapping_size);
+    }
+
+    bool good() const { return mapping != nullptr; }
+
+    size_t size() const { return count; }
+
+    const Snapshot& operator[](size_t i) const { return *reinterpret_cast<const Snapshot*>(record(i)); }
+
+    // record i's cross-checks, or nullptr if the file has none
+    const SnapshotCrosses* crosses(size_t i) const {
+        if ((header.flags & SnapshotHeader::CROSSES) == 0) return nullptr;
+        return reinterpret_cast<const SnapshotCrosses*>(record(i) + sizeof(Snapshot));
+    }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+// Hot-path counters and phase timers, compiled in with -DSCRABBLE_STATS.
+// Without it the STAT_ macros expand to nothing, so the normal build pays
+// nothing for them.
+
+#ifdef SCRABBLE_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+namespace stats {
+
+enum Counter {
+    NODES_VISITED = 0,  // trie nodes entered by the move generators
+    ANCHORS,            // anchors generated from
+    MOVES_EMITTED,      // moves passed to a sink
+    IS_LEGAL_CALLS,     // Trie::isLegal lookups
+    CROSS_UPDATES,      // cells whose cross-checks were recomputed
+    RACK_MUTATIONS,     // tiles added to or taken off a rack
+    COUNTER_COUNT
+};
+
+enum Phase {
+    HUMAN_INPUT = 0,
+    CROSS_UPDATE,
+    GENERATION,
+    SELECTION,
+    PLACEMENT,  // includes its CROSS_UPDATE
+    PHASE_COUNT
+};
+
+// Move generation runs on several threads, so each value is a relaxed atomic
+// on its own cache line.
+struct alignas(64) Slot {
+    std::atomic<uint64_t> value{0};
+};
+
+inline Slot counters[COUNTER_COUNT];
+inline Slot phase_ns[PHASE_COUNT];
+
+inline void count(Counter counter) { counters[counter].value.fetch_add(1, std::memory_order_relaxed); }
+
+class PhaseTimer {
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    PhaseTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        phase_ns[phase].value.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+};
+
+// Where report writes; stderr unless --stats names a file.
+inline std::ostream* out = nullptr;
+
+// Writes one line with everything counted since the last report, then
+// starts counting again from zero.
+inline void report(std::ostream& fallback, const char* label) {
+    static const char* COUNTER_NAMES[] = { "nodes", "anchors", "moves", "isLegal", "crosses", "rack" };
+    static const char* PHASE_NAMES[] = { "input", "cross", "generate", "select", "place" };
+    std::ostream& os = out != nullptr ? *out : fallback;
+    os << label;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        os << " " << COUNTER_NAMES[i] << "=" << counters[i].value.exchange(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        os << " " << PHASE_NAMES[i] << "_us=" << phase_ns[i].value.exchange(0, std::memory_order_relaxed) / 1000;
+    }
+    os << std::endl;
+}
+
+}  // namespace stats
+
+#define STAT_COUNT(counter) stats::count(stats::counter)
+#define STAT_TIME(phase) stats::PhaseTimer stat_timer_##phase(stats::phase)
+#define STAT_REPORT(label) stats::report(std::cerr, label)
+
+#else
+
+#define STAT_COUNT(counter) do {} while (0)
+#define STAT_TIME(phase) do {} while (0)
+#define STAT_REPORT(label) do {} while (0)
+
+#endif
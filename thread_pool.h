@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, each with its own task deque. Workers take
+// tasks from the front of their own deque and, when it runs dry, steal from
+// the back of the others, so uneven tasks (a crowded board line next to an
+// empty one) still spread across all threads.
+class ThreadPool {
+private:
+    typedef std::function<void()> Task;
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> next_queue{0};
+
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    bool popFront(size_t idx, Task& task) {
+        Queue& queue = *queues[idx];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    bool stealBack(size_t idx, Task& task) {
+        Queue& queue = *queues[idx];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    // Runs one queued task, preferring queue self. Returns false if every
+    // queue was empty.
+    bool runOne(size_t self) {
+        Task task;
+        bool found = popFront(self, task);
+        for (size_t i = 1; !found && i < queues.size(); i++) {
+            found = stealBack((self + i) % queues.size(), task);
+        }
+        if (!found) return false;
+        queued--;
+        task();
+        return true;
+    }
+
+    void work(size_t self) {
+        while (true) {
+            if (runOne(self)) continue;
+            std::unique_lock<std::mutex> guard(sleep_lock);
+            wake.wait(guard, [&] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+        }
+    }
+
+public:
+    // threads == 0 means one per hardware thread.
+    explicit ThreadPool(unsigned threads) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; i++) this->threads.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    unsigned size() const { return threads.size(); }
+
+    void submit(Task task) {
+        Queue& queue = *queues[next_queue++ % queues.size()];
+        // counted before it is pushed, so a worker that takes it at once
+        // cannot bring queued below zero
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            queued++;
+        }
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(0) ... body(count - 1) on the pool and waits for all of them.
+    // The calling thread runs queued tasks while it waits, so this can be
+    // called from inside a task without starving the pool.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body) {
+        size_t remaining = count;
+        std::mutex done_lock;
+        std::condition_variable done;
+        for (size_t i = 0; i < count; i++) {
+            submit([&, i] {
+                body(i);
+                std::lock_guard<std::mutex> guard(done_lock);
+                if (--remaining == 0) done.notify_all();
+            });
+        }
+        size_t self = next_queue % queues.size();
+        while (true) {
+            {
+                std::lock_guard<std::mutex> guard(done_lock);
+                if (remaining == 0) return;
+            }
+            if (runOne(self)) continue;
+            std::unique_lock<std::mutex> guard(done_lock);
+            done.wait_for(guard, std::chrono::milliseconds(1), [&] { return remaining == 0; });
+        }
+    }
+};
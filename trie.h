@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+// A node of the lexicon DAWG. Nodes live in one contiguous array: each one
+// holds a bitmask of the letters it has children for, its terminal flag, and
+// the offset (relative to itself) of its first child. A node's children are
+// stored consecutively in letter order, so childAt is a popcount away.
+//
+// Besides the 26 letters, a node can have a SEPARATOR child, which GADDAG
+// lexicons use to mark the turn from the reversed prefix to the suffix.
+class TrieNode {
+public:
+    static constexpr char SEPARATOR = 'Z' + 1;
+
+private:
+    static constexpr uint32_t TERMINAL = 1u << 31;
+    static constexpr uint32_t CHILDREN = (1u << 27) - 1;
+
+    uint32_t bits;
+    int32_t children;
+
+    friend class Trie;
+
+public:
+    TrieNode() : bits(0), children(0) {}
+
+    const TrieNode* childAt(char letter) const {
+        uint32_t bit = 1u << (letter - 'A');
+        if ((bits & bit) == 0) return nullptr;
+        return this + children + __builtin_popcount(bits & CHILDREN & (bit - 1));
+    }
+
+    // letters A-Z this node has children for, bit 0 being 'A'
+    uint32_t childMask() const { return bits & CHILDREN & ~(1u << (SEPARATOR - 'A')); }
+
+    bool isTerminal() const { return (bits & TERMINAL) != 0; }
+};
+
+static_assert(sizeof(TrieNode) == 8, "compiled lexicons depend on the TrieNode layout");
+
+// Header of a compiled lexicon file (see mklex.cc). The node array follows
+// it directly and is used in place, so the layout is fixed and native-endian.
+struct LexiconHeader {
+    static constexpr char MAGIC[8] = {'S', 'C', 'R', 'B', 'L', 'E', 'X', '\0'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t ENDIAN_CHECK = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_check;
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t node_count;
+    uint64_t state_count;
+};
+
+class Trie {
+public:
+    // A DAWG accepts the words themselves. A GADDAG accepts, for every word
+    // and every split point, the reversed prefix followed by SEPARATOR and the
+    // suffix (the separator is left out when the suffix is empty), so moves
+    // can be grown in both directions from a tile on the board.
+    enum Kind { DAWG = 0, GADDAG };
+
+private:
+    Kind kind = Kind::DAWG;
+    std::vector<TrieNode> storage;
+    const TrieNode* nodes = nullptr;
+    size_t node_count = 0;
+    size_t state_count = 0;
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    // Whether every node's children lie within the count nodes of the
+    // array, so that walking a mapped file cannot read past its end.
+    static bool childrenInBounds(const TrieNode* nodes, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            int children = __builtin_popcount(nodes[i].bits & TrieNode::CHILDREN);
+            if (children == 0) continue;
+            int64_t first = static_cast<int64_t>(i) + nodes[i].children;
+            if (first < 0 || first + children > static_cast<int64_t>(count)) return false;
+        }
+        return true;
+    }
+
+    // What fromLexicon made of a file.
+    enum class LoadResult { LOADED, NOT_COMPILED, INCOMPATIBLE };
+
+    // Maps a compiled lexicon read-only. Returns NOT_COMPILED, leaving the
+    // trie untouched, if the file is not a compiled lexicon at all, and
+    // INCOMPATIBLE, with the reason in problem, if it is one this build
+    // cannot use.
+    LoadResult fromLexicon(std::string filename, Kind expected, std::string& problem) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return LoadResult::NOT_COMPILED;
+        struct stat st;
+        LexiconHeader header;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(header) ||
+            pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+            memcmp(header.magic, LexiconHeader::MAGIC, sizeof(header.magic)) != 0) {
+            close(fd);
+            return LoadResult::NOT_COMPILED;
+        }
+        if (header.version != LexiconHeader::VERSION ||
+            header.endian_check != LexiconHeader::ENDIAN_CHECK ||
+            header.node_count == 0 ||
+            sizeof(header) + header.node_count * sizeof(TrieNode) != static_cast<size_t>(st.st_size)) {
+            problem = filename + ": incompatible lexicon, recompile it with mklex";
+            close(fd);
+            return LoadResult::INCOMPATIBLE;
+        }
+        if (header.kind != expected) {
+            problem = filename + ": expected a " + (expected == Kind::GADDAG ? "GADDAG" : "DAWG") + " lexicon";
+            close(fd);
+            return LoadResult::INCOMPATIBLE;
+        }
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            problem = filename + ": " + strerror(errno);
+            return LoadResult::INCOMPATIBLE;
+        }
+        const TrieNode* mapped = reinterpret_cast<const TrieNode*>(static_cast<const char*>(addr) + sizeof(header));
+        if (!childrenInBounds(mapped, header.node_count)) {
+            problem = filename + ": corrupt lexicon, recompile it with mklex";
+            munmap(addr, st.st_size);
+            return LoadResult::INCOMPATIBLE;
+        }
+        mapping = addr;
+        mapping_size = st.st_size;
+        nodes = mapped;
+        kind = expected;
+        node_count = header.node_count;
+        state_count = header.state_count;
+        return LoadResult::LOADED;
+    }
+
+    // Uppercases the words and drops anything that is not made of A-Z.
+    static std::vector<std::string> normalize(std::vector<std::string> words) {
+        for (std::string& word : words) {
+            for (char& ch : word) ch = toupper(ch);
+        }
+        words.erase(std::remove_if(words.begin(), words.end(), [](const std::string& word) {
+            return word.empty() || std::any_of(word.begin(), word.end(), [](char ch) {
+                return ch < 'A' || ch > 'Z';
+            });
+        }), words.end());
+        return words;
+    }
+
+    static std::vector<std::string> gaddagStrings(const std::vector<std::string>& words) {
+        std::vector<std::string> ret;
+        for (const std::string& word : words) {
+            for (size_t i = 1; i <= word.length(); i++) {
+                std::string entry(word.rbegin() + (word.length() - i), word.rend());
+                if (i < word.length()) {
+                    entry += TrieNode::SEPARATOR;
+                    entry.append(word, i, std::string::npos);
+                }
+                ret.push_back(std::move(entry));
+            }
+        }
+        return ret;
+    }
+
+    void fromWords(std::vector<std::string> words, Kind kind) {
+        this->kind = kind;
+        words = normalize(std::move(words));
+        if (kind == Kind::GADDAG) words = gaddagStrings(words);
+        build(std::move(words));
+    }
+
+    // Builds a minimized DAWG with the incremental algorithm for sorted input
+    // (Daciuk et al.), then flattens it into the node array.
+    void build(std::vector<std::string> words) {
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+
+        struct State {
+            bool terminal = false;
+            std::vector<std::pair<char, uint32_t>> edges;
+        };
+        std::vector<State> states(1);
+        std::vector<uint32_t> free_states;
+        std::unordered_map<std::string, uint32_t> registry;
+
+        auto signature = [&](uint32_t id) {
+            const State& state = states[id];
+            std::string ret(1, state.terminal ? '1' : '0');
+            for (auto& edge : state.edges) {
+                ret += edge.first;
+                ret.append(reinterpret_cast<const char*>(&edge.second), sizeof(edge.second));
+            }
+            return ret;
+        };
+
+        // path[i] is the state reached after the first i letters of the last word
+        std::vector<uint32_t> path = {0};
+        auto minimize = [&](size_t down_to) {
+            while (path.size() > down_to + 1) {
+                uint32_t child = path.back();
+                path.pop_back();
+                auto found = registry.emplace(signature(child), child);
+                if (!found.second) {
+                    states[path.back()].edges.back().second = found.first->second;
+                    states[child] = State();
+                    free_states.push_back(child);
+                }
+            }
+        };
+
+        std::string last = "";
+        for (const std::string& word : words) {
+            size_t common = 0;
+            while (common < word.length() && common < last.length() && word[common] == last[common]) {
+                common++;
+            }
+            minimize(common);
+            for (size_t i = common; i < word.length(); i++) {
+                uint32_t id = states.size();
+                if (free_states.empty()) {
+                    states.emplace_back();
+                } else {
+                    id = free_states.back();
+                    free_states.pop_back();
+                }
+                states[path.back()].edges.emplace_back(word[i], id);
+                path.push_back(id);
+            }
+            states[path.back()].terminal = true;
+            last = word;
+        }
+        minimize(0);
+        state_count = registry.size() + 1;
+
+        // Lay out child blocks breadth-first from the root so the top of the
+        // graph stays together. States with the same outgoing edges (they can
+        // only differ in their terminal flag) share one block.
+        std::vector<int64_t> block_of(states.size(), -1);
+        std::map<std::vector<std::pair<char, uint32_t>>, uint32_t> blocks;
+        std::deque<uint32_t> queue = {0};
+        std::vector<bool> seen(states.size(), false);
+        seen[0] = true;
+        uint32_t next = 1;
+        std::vector<uint32_t> order;
+        while (!queue.empty()) {
+            uint32_t id = queue.front();
+            queue.pop_front();
+            const State& state = states[id];
+            if (state.edges.empty()) continue;
+            auto found = blocks.emplace(state.edges, next);
+            block_of[id] = found.first->second;
+            if (found.second) {
+                next += state.edges.size();
+                order.push_back(id);
+            }
+            for (auto& edge : state.edges) {
+                if (!seen[edge.second]) {
+                    seen[edge.second] = true;
+                    queue.push_back(edge.second);
+                }
+            }
+        }
+
+        auto makeNode = [&](uint32_t id, uint32_t at) {
+            TrieNode node;
+            const State& state = states[id];
+            if (state.terminal) node.bits |= TrieNode::TERMINAL;
+            for (auto& edge : state.edges) node.bits |= 1u << (edge.first - 'A');
+            if (block_of[id] >= 0) node.children = static_cast<int32_t>(block_of[id] - at);
+            return node;
+        };
+
+        storage.assign(next, TrieNode());
+        storage[0] = makeNode(0, 0);
+        for (uint32_t id : order) {
+            uint32_t at = block_of[id];
+            for (auto& edge : states[id].edges) {
+                storage[at] = makeNode(edge.second, at);
+                at++;
+            }
+        }
+        nodes = storage.data();
+        node_count = storage.size();
+    }
+
+public:
+    Trie(std::vector<std::string> words, Kind kind = Kind::DAWG) {
+        fromWords(std::move(words), kind);
+    }
+
+    // Loads either a compiled lexicon (mapped in place) or a word list with
+    // one word per line. A compiled lexicon this build cannot use, such as
+    // one from an older mklex, throws std::runtime_error rather than being
+    // read as a word list.
+    Trie(std::string filename, Kind kind = Kind::DAWG) {
+        std::string problem;
+        LoadResult result = fromLexicon(filename, kind, problem);
+        if (result == LoadResult::LOADED) return;
+        if (result == LoadResult::INCOMPATIBLE) throw std::runtime_error(problem);
+        std::ifstream fin(filename);
+        std::vector<std::string> words;
+        if (fin.is_open()) {
+            std::string line;
+            while (getline(fin, line)) {
+                words.push_back(line);
+            }
+            fin.close();
+        }
+        fromWords(std::move(words), kind);
+    }
+
+    Trie(const Trie&) = delete;
+    Trie& operator=(const Trie&) = delete;
+
+    ~Trie() {
+        if (mapping != nullptr) munmap(mapping, mapping_size);
+    }
+
+    // Writes the trie as a compiled lexicon that the constructor can map.
+    bool save(std::string filename) const {
+        LexiconHeader header;
+        memcpy(header.magic, LexiconHeader::MAGIC, sizeof(header.magic));
+        header.version = LexiconHeader::VERSION;
+        header.endian_check = LexiconHeader::ENDIAN_CHECK;
+        header.kind = kind;
+        header.reserved = 0;
+        header.node_count = node_count;
+        header.state_count = state_count;
+        std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(nodes), node_count * sizeof(TrieNode));
+        return fout.good();
+    }
+
+    bool isLegal(std::string word) const {
+        STAT_COUNT(IS_LEGAL_CALLS);
+        const TrieNode* curr = getRoot();
+        for (char ch : word) {
+            ch = toupper(ch);
+            if (ch < 'A' || ch > 'Z') return false;
+            curr = curr->childAt(ch);
+            if (curr == nullptr) return false;
+        }
+        return curr->isTerminal();
+    }
+
+    const TrieNode* getRoot() const { return nodes; }
+
+    Kind getKind() const { return kind; }
+
+    bool isMapped() const { return mapping != nullptr; }
+
+    // number of states in the minimized graph
+    size_t nodeCount() const { return state_count; }
+
+    // entries in the node array; a node's index is its offset from the root
+    size_t arraySize() const { return node_count; }
+
+    // bytes taken by the node array
+    size_t byteSize() const { return node_count * sizeof(TrieNode); }
+};
+
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lexicon.h"
+#include "query.h"
+
+// Parses RACK or RACK:PATTERN, where RACK may be empty or '-' for none.
+WordQuery parseQuery(const std::string& text, bool all_tiles) {
+    WordQuery query;
+    size_t colon = text.find(':');
+    query.rack = text.substr(0, colon);
+    if (query.rack == "-") query.rack = "";
+    if (colon != std::string::npos) query.pattern = text.substr(colon + 1);
+    query.all_tiles = all_tiles;
+    return query;
+}
+
+// Finds the words for each query on the command line, or for each line of
+// standard input if there are none, answering them all as one batch.
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    bool all_tiles = false;
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        std::string opt = argv[arg];
+        if (opt == "-t" && arg + 1 < argc) threads = std::stoul(argv[++arg]);
+        else if (opt == "-x") all_tiles = true;
+        else if (opt == "-h" || opt == "--help") {
+            std::cerr << "usage: " << argv[0] << " [-t threads] [-x] [RACK[:PATTERN] ...]" << std::endl;
+            std::cerr << "  RACK     tiles to spell with, ? for a blank, - for no rack" << std::endl;
+            std::cerr << "  PATTERN  letters, ? for any one letter, * for any run (default *)" << std::endl;
+            std::cerr << "  -x       only words that use the whole rack" << std::endl;
+            return 1;
+        } else break;
+    }
+
+    std::vector<std::string> texts(argv + arg, argv + argc);
+    if (texts.empty()) {
+        std::string line;
+        while (getline(std::cin, line)) {
+            if (!line.empty()) texts.push_back(line);
+        }
+    }
+    std::vector<WordQuery> queries;
+    for (const std::string& text : texts) queries.push_back(parseQuery(text, all_tiles));
+
+    Lexicon lexicon(false, "");
+    WordFinder finder(lexicon.words());
+    ThreadPool pool(threads);
+    std::vector<std::vector<std::string>> answers = finder.findAll(queries, &pool);
+
+    for (size_t i = 0; i < texts.size(); i++) {
+        std::cout << texts[i] << " (" << answers[i].size() << "):";
+        for (const std::string& word : answers[i]) std::cout << " " << word;
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}